@@ -0,0 +1,21 @@
+#ifndef SHADER_DEFINES_H
+#define SHADER_DEFINES_H
+
+#include <string>
+
+// Insert defines (e.g. "#define FOO 1\n") into shader source so a single source can be
+// compiled in variants. #version must stay the first statement, so they go right after its line.
+inline void insertShaderDefines(std::string& code, const std::string& defines)
+{
+    if (defines.empty())
+    {
+        return;
+    }
+
+    size_t versionPos = code.find("#version");
+    size_t insertPos = versionPos == std::string::npos ? 0 : code.find('\n', versionPos);
+    insertPos = insertPos == std::string::npos ? code.size() : insertPos + 1;
+    code.insert(insertPos, defines);
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "shader_defines.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,10 +15,11 @@ class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly. defines (e.g. "#define FOO 1\n") are
+    // inserted right after the #version line of every stage.
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
-           const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr)
+           const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr, const std::string& defines = "")
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -78,6 +81,11 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        insertShaderDefines(vertexCode, defines);
+        insertShaderDefines(fragmentCode, defines);
+        insertShaderDefines(geometryCode, defines);
+        insertShaderDefines(tessControlCode, defines);
+        insertShaderDefines(tessEvalCode, defines);
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
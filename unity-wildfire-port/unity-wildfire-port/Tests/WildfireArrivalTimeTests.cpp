@@ -0,0 +1,100 @@
+// ----------------------------------------------------------------------------
+//
+// Checks of the arrival time engine on small synthetic landscapes. No window or images are
+// needed; build and run from this directory with:
+//
+//   g++ -std=c++14 -I../../Include -I../unity-wildfire-port WildfireArrivalTimeTests.cpp ../unity-wildfire-port/WildfireArrivalTime.cpp -o arrival_time_tests && ./arrival_time_tests
+//
+// Returns non-zero if a check fails.
+//
+// ----------------------------------------------------------------------------
+
+#include "WildfireArrivalTime.h"
+
+#include <iostream>
+
+constexpr int GRID_SIZE = 64;
+
+// The cells the checks compare, 20 cells east and west of the ignition at the grid center.
+constexpr int EAST_CELL_INDEX = (GRID_SIZE / 2) * GRID_SIZE + GRID_SIZE / 2 + 20;
+constexpr int WEST_CELL_INDEX = (GRID_SIZE / 2) * GRID_SIZE + GRID_SIZE / 2 - 20;
+
+static int failedCheckCount = 0;
+
+static void check(bool bCondition, const char* description)
+{
+    std::cout << (bCondition ? "PASS " : "FAIL ") << description << std::endl;
+    if (!bCondition) {
+        ++failedCheckCount;
+    }
+}
+
+// A forest rising towards the east by heightStep (of 65535) per cell.
+static WildfireLandscape createForest(int heightStep)
+{
+    WildfireLandscape landscape;
+    landscape.width = GRID_SIZE;
+    landscape.height = GRID_SIZE;
+    landscape.materials.assign((size_t)GRID_SIZE * GRID_SIZE, MATERIAL_TREE_1);
+    landscape.heights.resize((size_t)GRID_SIZE * GRID_SIZE);
+
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            landscape.heights[(size_t)y * GRID_SIZE + x] = (uint16_t)(x * heightStep);
+        }
+    }
+
+    return landscape;
+}
+
+static std::vector<float> computeArrivalTimes(const WildfireLandscape& landscape, float windAngleDegrees, bool bUseSlope)
+{
+    WildfireParameters parameters;
+    parameters.windDirectionIndex = WIND_DIRECTION_ANGLE;
+    parameters.windAngleDegrees = windAngleDegrees;
+    parameters.bUseSlope = bUseSlope;
+
+    // Keep the upwind edges, so every cell of the forest is reached.
+    WildfireArrivalTimeSettings settings;
+    settings.minSpreadProbability = 0.0f;
+
+    return computeWildfireArrivalTimes(landscape, parameters, glm::vec2(0.5f, 0.5f), settings);
+}
+
+static void checkWindAngle()
+{
+    const WildfireLandscape landscape = createForest(0);
+
+    const std::vector<float> eastWind = computeArrivalTimes(landscape, 0.0f, true);
+    const std::vector<float> westWind = computeArrivalTimes(landscape, 180.0f, true);
+
+    check(eastWind[EAST_CELL_INDEX] < eastWind[WEST_CELL_INDEX], "an east wind reaches the east cell first");
+    check(westWind[WEST_CELL_INDEX] < westWind[EAST_CELL_INDEX], "a west wind reaches the west cell first");
+    check(eastWind[EAST_CELL_INDEX] == westWind[WEST_CELL_INDEX], "turning the wind around mirrors the arrival times");
+}
+
+static void checkSlope()
+{
+    const WildfireLandscape landscape = createForest(16);
+
+    const std::vector<float> withSlope = computeArrivalTimes(landscape, 90.0f, true);
+    const std::vector<float> withoutSlope = computeArrivalTimes(landscape, 90.0f, false);
+
+    check(withSlope[EAST_CELL_INDEX] < withoutSlope[EAST_CELL_INDEX], "the slope speeds up the fire uphill");
+    check(withSlope[WEST_CELL_INDEX] == withoutSlope[WEST_CELL_INDEX], "the slope does not change the fire downhill");
+    check(withoutSlope[EAST_CELL_INDEX] == withoutSlope[WEST_CELL_INDEX], "without the slope the terrain is ignored");
+}
+
+int main()
+{
+    checkWindAngle();
+    checkSlope();
+
+    if (failedCheckCount > 0) {
+        std::cout << failedCheckCount << " checks failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
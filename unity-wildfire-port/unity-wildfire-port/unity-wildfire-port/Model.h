@@ -10,6 +10,7 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "WildfireTrace.h"
 #include <learnopengl/shader_t.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/shader_c.h>
@@ -54,6 +55,8 @@ private:
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const& path)
     {
+        WILDFIRE_TRACE_ZONE("Model::loadModel");
+
         // read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -209,6 +212,8 @@ private:
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
 {
+    WILDFIRE_TRACE_ZONE("TextureFromFile");
+
     string filename = string(path);
     filename = directory + '/' + filename;
 
@@ -8,46 +8,50 @@ out vec4 FragColor;
 
 // The PNG texture we are reading from.
 uniform sampler2D landscapeTexture;
-uniform sampler2D wildfireTexture;
+uniform usampler2D wildfireTexture;
+uniform sampler2D wildfireHeightTexture;
 
 void main()
 {
     vec2 uv = TexCoord;
 
-	vec4 textureData = texture(wildfireTexture, uv);
+	// .r is the material, .g is the state (MATERIAL_* and STATE_* are injected by the host).
+	uvec4 textureData = texture(wildfireTexture, uv);
+	int material = int(textureData.r);
+	int state = int(textureData.g);
 
-    float heightValue = textureData.b * 255;
+    float heightValue = texture(wildfireHeightTexture, uv).r * 255;
 
 	// Convert float (0-1) to uint8 (0-255) and clamp values
-	if (textureData.g == 1.0) {
+	if (state == STATE_ON_FIRE) {
 		// On Fire
 		FragColor = vec4(vec3(255., 119., 0.) / 255., 1.0);
 	}
-	else if (textureData.g == 2.0f) {
+	else if (state == STATE_DESTROYED) {
 		// Destroyed
 		FragColor = vec4(vec3(0., 0., 0.) / 255., 1.0);
 	}
-	else if (textureData.r == 0.0f) {
+	else if (material == MATERIAL_GRASS) {
 		// Grass
 		FragColor = vec4(vec3(min(255., 121. + heightValue), min(255., 150. + heightValue), min(255., 114. + heightValue)) / 255., 1.0);
 	}
-	else if (textureData.r == 1.0f) {
+	else if (material == MATERIAL_WATER) {
 		// Water
 		FragColor = vec4(vec3(181., 219., 235.) / 255., 1.0);
 	}
-	else if (textureData.r == 2.0f) {
+	else if (material == MATERIAL_BEDROCK) {
 		// Bedrock
 		FragColor = vec4(vec3(min(255., 207. + heightValue), min(255., 198. + heightValue), min(255., 180. + heightValue)) / 255., 1.0);
 	}
-	else if (textureData.r == 3.0f) {
+	else if (material == MATERIAL_TREE_1) {
 		// Tree 1
 		FragColor = vec4(vec3(min(255., 32. + heightValue), min(255., 99. + heightValue), min(255., 84. + heightValue)) / 255., 1.0);
 	} 
-	else if (textureData.r == 4.0f) {
+	else if (material == MATERIAL_TREE_2) {
 		// Tree 2	
 		FragColor= vec4(vec3(min(255., 66. + heightValue), min(255., 143. + heightValue), min(255., 30. + heightValue)) / 255., 1.0);
 	}
-	else if (textureData.r == 5.0f) {
+	else if (material == MATERIAL_TREE_3) {
 		// Tree 3
 		FragColor = vec4(vec3(min(255., 185. + heightValue), min(255., 209. + heightValue), min(255., 50. + heightValue)) / 255., 1.0);
 	}
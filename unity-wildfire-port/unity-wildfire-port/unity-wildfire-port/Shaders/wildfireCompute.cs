@@ -1,126 +1,279 @@
 #version 430 core
 
-layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
-
 // ----------------------------------------------------------------------------
 //
-// Macros for materials
+// Kernel selection
+//
+// The host injects WILDFIRE_TILED and TILE_SIZE after the #version line. The tiled
+// kernel runs TILE_SIZE x TILE_SIZE invocations per workgroup, loads the tile plus a
+// one cell halo into shared memory once, and reads every neighbour from there.
+// Without WILDFIRE_TILED this is the reference kernel: one invocation per workgroup
+// and one imageLoad per neighbour.
 //
 // ----------------------------------------------------------------------------
-#define MATERIAL_GRASS 0
-#define MATERIAL_WATER 1
-#define MATERIAL_BEDROCK 2
-#define MATERIAL_TREE_1 3
-#define MATERIAL_TREE_2 4
-#define MATERIAL_TREE_3 5
+#ifndef WILDFIRE_TILED
+#undef TILE_SIZE
+#define TILE_SIZE 1
+#endif
+
+#ifndef TILE_SIZE
+#define TILE_SIZE 16
+#endif
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE, local_size_z = 1) in;
 
 // ----------------------------------------------------------------------------
 //
-// Macros for states
+// Shared definitions and rule permutations
+//
+// The host also injects the materials (MATERIAL_*), states (STATE_*), random draw indices
+// (RANDOM_*) and rule constants from their C++ definitions, and compiles one permutation
+// per rule combination with USE_TEMP, USE_REGROWTH, USE_VON_NEUMANN, USE_WIND_FIELD and
+// USE_SLOPE set to 0 or 1 (see WildfireShaderDefinitions.h).
 //
 // ----------------------------------------------------------------------------
-#define STATE_NOT_ON_FIRE 0
-#define STATE_ON_FIRE 1
-#define STATE_DESTROYED 2
 
 // ----------------------------------------------------------------------------
 //
 // Uniforms
 //
 // ----------------------------------------------------------------------------
-layout(rgba32f, binding = 2) uniform image2D materialStateHeightTexture_READ;
-layout(rgba32f, binding = 3) uniform image2D materialStateHeightTexture_WRITE;
+// .r is the material, .g is the state. The height lives in its own static plane.
+layout(rg8ui, binding = 2) uniform readonly uimage2D materialStateTexture_READ;
+layout(rg8ui, binding = 3) uniform writeonly uimage2D materialStateTexture_WRITE;
+layout(r16, binding = 4) uniform readonly image2D heightTexture;
+
+// Static plane of upslope spread multipliers: nibble k is the level for fire arriving from
+// neighbour k (see computeWildfireSlopeFactors in WildfireLandscape.cpp).
+layout(r32ui, binding = 5) uniform readonly uimage2D slopeFactorTexture;
+
+// Step on which the pending burnout or regrowth of each cell fires, or WILDFIRE_TIMER_NEVER
+// (see SampleTimer in WildfireRules.h). Each invocation only touches its own cell, so the
+// plane is updated in place.
+layout(r32ui, binding = 0) uniform uimage2D timerTexture;
+
+// Set when the timers are unknown or were drawn with other regrowth probabilities: every cell
+// redraws its timer before it is stepped.
+uniform bool resampleTimers = false;
+
+#ifdef WILDFIRE_TILED
+#define TILE_SIZE_WITH_HALO (TILE_SIZE + 2)
+
+// The tile and its one cell halo, packed as material | (state << 8).
+shared uint tileCells[TILE_SIZE_WITH_HALO][TILE_SIZE_WITH_HALO];
+
+// Grid coordinate of the first cell of this workgroup's tile.
+ivec2 tileOrigin;
+#endif
+
+#ifdef WILDFIRE_EMIT_CHANGES
+// Compacted list of the cells this step changed, as (cell index, material | state << 8).
+// changeCount keeps counting past the end of the array, so the host can tell it overflowed.
+layout(std430, binding = 0) buffer WildfireChanges
+{
+    uint changeCount;
+    uint changePadding;
+    uvec2 changes[];
+};
+#endif
+
+#ifdef WILDFIRE_STATS
+// Statistics of the grid this step reads and the cells it sets on fire, summed over every workgroup. The buffer is a ring
+// of records of STATS_COUNTER_COUNT counters (see WildfireStats.h); the host clears record
+// statsRecordIndex before the dispatch and reads it back once the step's fence signals.
+#define STATS_BURNING 0
+#define STATS_PERIMETER 1
+#define STATS_IGNITED 2
+#define STATS_COUNTER_COUNT (STATS_IGNITED + MATERIAL_COUNT)
+
+layout(std430, binding = 1) buffer WildfireStats
+{
+    uint statsCounters[];
+};
+
+uniform uint statsRecordIndex = 0u;
 
-layout(location = 0) uniform float iTime;
-uniform int frameCounter = 0;
+// Workgroup partial sums, so each workgroup does at most STATS_COUNTER_COUNT global atomics.
+shared uint workgroupStats[STATS_COUNTER_COUNT];
+#endif
+
+// Spread probability per mask of burning neighbours, and flammable probability per material.
+// The host rebuilds it whenever the wind or a flammable probability changes (see
+// WildfireRuleTable in WildfireRules.h), so a cell does one lookup instead of a wind loop.
+layout(std430, binding = 2) readonly buffer WildfireRuleTable
+{
+    float spreadProbabilities[256];
+    float flammableProbabilities[MATERIAL_COUNT];
+};
+
+// Gridded wind forecast (see WildfireWindField.h). The two frames around this step sit in two
+// layers of a low resolution RG32F texture array, which is sampled bilinearly over the grid
+// and blended by windFieldBlend in time. With USE_WIND_FIELD it replaces the rule table's wind.
+layout(binding = 7) uniform sampler2DArray windField;
+uniform ivec2 windFieldLayers = ivec2(0, 0);
+uniform float windFieldBlend = 0.0f;
+
+// Key of the random numbers (low and high 32 bits) and the number of steps simulated so far.
+uniform uvec2 seed = uvec2(0u, 0u);
+uniform uint simulationStep = 0u;
 uniform bool mouseDown;
 uniform vec2 mousePos;
 
-uniform int windDirectionIndex = 6;
-
 uniform float FIRE_PROB = 0.0f;
-uniform float FLAMMABLE_PROBABILITY_FOR_GRASS = 0.01f;
-uniform float FLAMMABLE_PROBABILITY_FOR_WATER = 0.0f;
-uniform float FLAMMABLE_PROBABILITY_FOR_BEDROCK = 0.1f;
-uniform float FLAMMABLE_PROBABILITY_FOR_TREE = 0.75f;
 
 uniform float GRASS_REGROW_PROBABILITY = 0.0f;
 uniform float TREE_REGROW_PROBABILITY = 0.0f;
 
-uniform bool USE_TEMP = true;
-uniform bool USE_WIND = true;
-
 // ----------------------------------------------------------------------------
 //
 // Functions
 //
 // ----------------------------------------------------------------------------
 
-// Pseudo-random number generator
-vec3 hash33(vec3 p3)
+// Counter-based random numbers (Philox4x32-10). Same function as WildfireRandom.h, so the
+// CPU engine draws the same numbers for the same (seed, step, cell, draw).
+uvec4 PhiloxRandom(uvec4 counter, uvec2 key)
 {
-    p3 = fract(p3 * vec3(.1031, .1030, .0973));
-    p3 += dot(p3, p3.yxz + 33.33);
-    return fract((p3.xxy + p3.yxx) * p3.zyx);
+    for (int i = 0; i < 10; i++)
+    {
+        uint high0, low0, high1, low1;
+        umulExtended(0xD2511F53u, counter.x, high0, low0);
+        umulExtended(0xCD9E8D57u, counter.z, high1, low1);
+
+        counter = uvec4(high1 ^ counter.y ^ key.x, low1, high0 ^ counter.w ^ key.y, low0);
+
+        key += uvec2(0x9E3779B9u, 0xBB67AE85u);
+    }
+
+    return counter;
 }
 
-float random(vec2 coord)
+// Map 32 random bits to [0, 1) with 24 bits of precision.
+float RandomBitsToFloat(uint bits)
 {
-    // Create a 3D vector from our inputs
-    vec3 p = vec3(coord.x, coord.y, iTime);
+    return float(bits >> 8) * (1.0 / 16777216.0);
+}
 
-    // Add some large prime numbers to avoid patterns
-    p *= vec3(61.0, 157.0, 367.0);
+// All four draws of one block of a (cell, step) pair.
+uvec4 RandomBlock(uint cellIndex, uint block, uint stream)
+{
+    return PhiloxRandom(uvec4(cellIndex, simulationStep, block, stream), seed);
+}
 
-    // Use the first component of our hash
-    return hash33(p).x;
+float RandomFromBlock(uvec4 block, uint drawIndex)
+{
+    return RandomBitsToFloat(block[drawIndex & 3u]);
 }
 
-// Get cell data from texture
-vec4 GetCellData(vec2 coord)
+float random(uint cellIndex, uint drawIndex)
+{
+    return RandomFromBlock(RandomBlock(cellIndex, drawIndex >> 2, RANDOM_STREAM_CELL), drawIndex);
+}
+
+// Steps until a transition with this per step probability fires (see SampleTimerDelay in
+// WildfireRules.h).
+uint SampleTimerDelay(float probability, float u)
+{
+    if (probability <= 0.0)
+    {
+        return WILDFIRE_TIMER_NEVER;
+    }
+    if (probability >= 1.0)
+    {
+        return 1u;
+    }
+
+    float delay = 1.0 + floor(log(1.0 - u) / log(1.0 - probability));
+    return delay < 4294967040.0 ? uint(delay) : WILDFIRE_TIMER_NEVER;
+}
+
+// step + delay, saturating at WILDFIRE_TIMER_NEVER.
+uint AddTimerDelay(uint step, uint delay)
+{
+    return delay >= WILDFIRE_TIMER_NEVER - step ? WILDFIRE_TIMER_NEVER : step + delay;
+}
+
+// The timer of a cell which enters its state on this step.
+uint SampleTimer(uint cellIndex, float probability)
+{
+    return AddTimerDelay(simulationStep, SampleTimerDelay(probability, random(cellIndex, RANDOM_DRAW_TIMER)));
+}
+
+// Get cell data from texture. In the tiled kernel coord must be inside this tile or its halo.
+uvec4 GetCellData(vec2 coord)
 {
     ivec2 icoord = ivec2(coord);
-    return imageLoad(materialStateHeightTexture_READ, icoord);
+#ifdef WILDFIRE_TILED
+    ivec2 tileCoord = icoord - tileOrigin + 1;
+    uint packedCell = tileCells[tileCoord.y][tileCoord.x];
+    return uvec4(packedCell & 0xFFu, packedCell >> 8, 0u, 0u);
+#else
+    return imageLoad(materialStateTexture_READ, icoord);
+#endif
+}
+
+// Size of the simulation grid
+ivec2 GetGridSize()
+{
+    return imageSize(materialStateTexture_READ);
+}
+
+#ifdef WILDFIRE_TILED
+// Cooperatively load the tile and its halo into shared memory. Cells outside the grid read
+// as zero (not on fire), exactly like imageLoad does in the reference kernel.
+void LoadTile()
+{
+    tileOrigin = ivec2(gl_WorkGroupID.xy) * TILE_SIZE;
+
+    const int haloCellCount = TILE_SIZE_WITH_HALO * TILE_SIZE_WITH_HALO;
+    for (int i = int(gl_LocalInvocationIndex); i < haloCellCount; i += TILE_SIZE * TILE_SIZE)
+    {
+        ivec2 tileCoord = ivec2(i % TILE_SIZE_WITH_HALO, i / TILE_SIZE_WITH_HALO);
+        uvec4 cellData = imageLoad(materialStateTexture_READ, tileOrigin + tileCoord - 1);
+        tileCells[tileCoord.y][tileCoord.x] = cellData.x | (cellData.y << 8);
+    }
+
+    barrier();
 }
+#endif
 
 // Get material type as an integer
-int GetMaterial(vec4 cellData)
+int GetMaterial(uvec4 cellData)
 {
     return int(cellData.x);
 }
 
 // Set the material of a cell
-void SetMaterial(inout vec4 cellData, int material)
+void SetMaterial(inout uvec4 cellData, int material)
 {
-    cellData.x = float(material);
+    cellData.x = uint(material);
 }
 
 // Get state as an integer
-int GetState(vec4 cellData)
+int GetState(uvec4 cellData)
 {
     return int(cellData.y);
 }
 
 // Set the state of a cell
-void SetState(inout vec4 cellData, int state)
+void SetState(inout uvec4 cellData, int state)
 {
-    cellData.y = float(state);
+    cellData.y = uint(state);
 }
 
-// Get height value from cell data
-float GetHeight(vec4 cellData)
+// Get the normalized height of a cell from the static height plane
+float GetHeight(vec2 coord)
 {
-    return cellData.z;
+    return imageLoad(heightTexture, ivec2(coord)).x;
 }
 
 float CalculateTemperature()
 {
-    if (!USE_TEMP)
-    {
-        return 20.0f; // Default temperature if system is disabled
-    }
+#if !USE_TEMP
+    return 20.0f; // Default temperature if system is disabled
+#endif
 
-    int hourOfDay = frameCounter % 24;
+    int hourOfDay = int(simulationStep % 24u);
     float average_temp = 20.0f;
     float amplitude = 5.0f;
 
@@ -128,17 +281,17 @@ float CalculateTemperature()
     float temp = average_temp + amplitude * sin(2.0 * 3.14159265 * float(hourOfDay) / 24.0 - 3.14159265 / 2.0);
 
     // Add some noise
-    temp += (random(vec2(hourOfDay, frameCounter)) - 0.5) * 2.0;
+    temp += (RandomFromBlock(RandomBlock(RANDOM_GLOBAL_CELL, 0u, RANDOM_STREAM_GLOBAL), 0u) - 0.5) * 2.0;
 
     return temp;
 }
 
 // mouse fire spawn
-bool IsImpactedByMouse(vec2 coord, inout vec4 cellData)
+bool IsImpactedByMouse(vec2 coord, inout uvec4 cellData)
 {
     if (mouseDown == true)
     {
-        ivec2 computeSize = ivec2(gl_NumWorkGroups.xy);
+        ivec2 computeSize = GetGridSize();
         vec2 fireCenter = computeSize * mousePos;
 
         float distance = length(fireCenter - coord);
@@ -152,51 +305,117 @@ bool IsImpactedByMouse(vec2 coord, inout vec4 cellData)
     return false;
 }
 
-float GetWindSpreadProb(vec2 coord)
+// Bit k is set when the k-th neighbour (x outer, y inner, skipping the cell itself) is on fire.
+uint GetBurningNeighborMask(vec2 coord)
 {
-    float prob = 0.0;
-
-    vec2 windDirection = vec2(0, 0);
+    uint mask = 0u;
+    uint neighbor = 0u;
 
-    if (windDirectionIndex == 1)
-    {
-        // east
-        windDirection = vec2(1, 0);
-    }
-    else if (windDirectionIndex == 2)
+    for (int i = -1; i <= 1; i++)
     {
-        // west
-        windDirection = vec2(-1, 0);
+        for (int j = -1; j <= 1; j++)
+        {
+            if (i == 0 && j == 0) continue;
+
+            if (GetState(GetCellData(coord + vec2(i, j))) == STATE_ON_FIRE)
+            {
+                mask |= 1u << neighbor;
+            }
+            neighbor++;
+        }
     }
-    else if (windDirectionIndex == 3)
+
+    return mask;
+}
+
+#ifdef WILDFIRE_STATS
+// Zero the workgroup sums. Every invocation must call this.
+void BeginStats()
+{
+    for (uint i = gl_LocalInvocationIndex; i < STATS_COUNTER_COUNT; i += TILE_SIZE * TILE_SIZE)
     {
-        // north
-        windDirection = vec2(0, 1);
+        workgroupStats[i] = 0u;
     }
-    else if (windDirectionIndex == 4)
+
+    barrier();
+}
+
+// Add one cell of the grid being read: burning cells, and the edges between a burning cell
+// and an unburnt, non-water neighbour inside the grid.
+void AccumulateStats(vec2 coord, uvec4 cellData)
+{
+    if (GetState(cellData) != STATE_ON_FIRE)
     {
-        // south
-        windDirection = vec2(0, -1);
+        return;
     }
-    else if (windDirectionIndex == 5)
+
+    atomicAdd(workgroupStats[STATS_BURNING], 1u);
+
+    const ivec2 neighborOffsets[4] = ivec2[4](ivec2(1, 0), ivec2(-1, 0), ivec2(0, 1), ivec2(0, -1));
+
+    uint perimeterEdgeCount = 0u;
+    for (int i = 0; i < 4; i++)
     {
-        // northeast
-        windDirection = vec2(1, 1);
+        ivec2 neighborCoord = ivec2(coord) + neighborOffsets[i];
+        if (any(lessThan(neighborCoord, ivec2(0))) || any(greaterThanEqual(neighborCoord, GetGridSize())))
+        {
+            continue;
+        }
+
+        uvec4 neighborData = GetCellData(vec2(neighborCoord));
+        if (GetState(neighborData) == STATE_NOT_ON_FIRE && GetMaterial(neighborData) != MATERIAL_WATER)
+        {
+            perimeterEdgeCount++;
+        }
     }
-    else if (windDirectionIndex == 6)
+
+    if (perimeterEdgeCount > 0u)
     {
-        // northwest
-        windDirection = vec2(-1, 1);
+        atomicAdd(workgroupStats[STATS_PERIMETER], perimeterEdgeCount);
     }
-    else if (windDirectionIndex == 7)
+}
+
+// Count a cell this step sets on fire towards the burned area of its material. Burnt cells
+// regrow, so the burned area is summed from these on the host instead of read off the grid.
+void CountIgnition(uvec4 previousCellData, uvec4 cellData)
+{
+    if (GetState(cellData) == STATE_ON_FIRE && GetState(previousCellData) != STATE_ON_FIRE)
     {
-        // southeast
-        windDirection = vec2(1, -1);
+        atomicAdd(workgroupStats[STATS_IGNITED + min(GetMaterial(cellData), MATERIAL_COUNT - 1)], 1u);
     }
-    else if (windDirectionIndex == 8)
+}
+
+// Add the workgroup sums to this step's record. Every invocation must call this.
+void EndStats()
+{
+    barrier();
+
+    for (uint i = gl_LocalInvocationIndex; i < STATS_COUNTER_COUNT; i += TILE_SIZE * TILE_SIZE)
     {
-        windDirection = vec2(-1, -1);
+        if (workgroupStats[i] > 0u)
+        {
+            atomicAdd(statsCounters[statsRecordIndex * STATS_COUNTER_COUNT + i], workgroupStats[i]);
+        }
     }
+}
+#endif
+
+// The wind at the center of a cell, in the units of the compass wind directions.
+vec2 SampleWindField(vec2 coord)
+{
+    vec2 uv = (coord + 0.5) / vec2(GetGridSize());
+    vec2 previousWind = texture(windField, vec3(uv, windFieldLayers.x)).xy;
+    vec2 nextWind = texture(windField, vec3(uv, windFieldLayers.y)).xy;
+    return mix(previousWind, nextWind, windFieldBlend);
+}
+
+// The rule table's spread probability, with the local wind of the field instead of the global one.
+float GetWindFieldSpreadProb(vec2 coord, uint burningNeighborMask)
+{
+    vec2 windDirection = SampleWindField(coord);
+
+    float prob = 0.0;
+    uint neighbor = 0u;
 
     for (int i = -1; i <= 1; i++)
     {
@@ -204,76 +423,111 @@ float GetWindSpreadProb(vec2 coord)
         {
             if (i == 0 && j == 0) continue;
 
-            vec2 neighborOffset = vec2(i, j);
-            vec4 otherCellData = GetCellData(coord + vec2(i, j));
-            int otherCellState = GetState(otherCellData);
-
-            if (otherCellState == STATE_ON_FIRE)
+            if ((burningNeighborMask & (1u << neighbor)) != 0u)
             {
-                if (windDirectionIndex == 0)
-                {
-                    return 1.0 / 8 / 2;
-                }
-
-                // Compute the dot product to check alignment with the wind
-                float windInfluence = max(0.0, dot(normalize(-neighborOffset), windDirection));
-
-                // Increase probability based on wind influence
+                float windInfluence = max(0.0, dot(normalize(-vec2(i, j)), windDirection));
                 prob += (0.1 + 0.9 * windInfluence) / 8;
             }
+            neighbor++;
         }
     }
 
     return prob;
 }
 
+// The strongest upslope multiplier of the burning neighbours: the fire runs uphill from the
+// lowest of them. One load covers all eight neighbours.
+float GetSlopeMultiplier(vec2 coord, uint burningNeighborMask)
+{
+    uint packedSlopeFactors = imageLoad(slopeFactorTexture, ivec2(coord)).r;
+
+    uint level = 0u;
+    for (uint neighbor = 0u; neighbor < 8u; neighbor++)
+    {
+        if ((burningNeighborMask & (1u << neighbor)) != 0u)
+        {
+            level = max(level, bitfieldExtract(packedSlopeFactors, int(4u * neighbor), 4));
+        }
+    }
+
+    return 1.0 + float(level) * SLOPE_MULTIPLIER_STEP;
+}
+
+// A fresh timer for a cell whose timer is unknown or stale: the transition may fire this step.
+uint ResampleTimer(uint cellIndex, uvec4 cellData)
+{
+    float probability = 0.0;
+    if (GetState(cellData) == STATE_ON_FIRE)
+    {
+        probability = BURNOUT_PROBABILITY;
+    }
+    else if (GetState(cellData) == STATE_DESTROYED)
+    {
+        probability = GRASS_REGROW_PROBABILITY;
+    }
+    else if (GetMaterial(cellData) == MATERIAL_GRASS)
+    {
+        probability = TREE_REGROW_PROBABILITY;
+    }
+
+    uint delay = SampleTimerDelay(probability, random(cellIndex, RANDOM_DRAW_TIMER_RESAMPLE));
+    return delay == WILDFIRE_TIMER_NEVER ? WILDFIRE_TIMER_NEVER : AddTimerDelay(simulationStep, delay - 1u);
+}
+
 // Process a single cell
-void processCell(vec2 coord, inout vec4 cellData)
+void processCell(vec2 coord, inout uvec4 cellData, inout uint timer)
 {
     int cellMaterial = GetMaterial(cellData);
     int cellState = GetState(cellData);
 
+    uint cellIndex = uint(coord.y) * uint(GetGridSize().x) + uint(coord.x);
+
     // TODO: Replace with wind implementation and add temperature factors.
     if (cellState == STATE_NOT_ON_FIRE)
     {
-        if (cellMaterial == MATERIAL_GRASS)
+        // Draws 0-3 share one Philox block.
+        uvec4 randomBlock = RandomBlock(cellIndex, 0u, RANDOM_STREAM_CELL);
+
+#if USE_REGROWTH
+        if (cellMaterial == MATERIAL_GRASS && simulationStep >= timer)
         {
-            float regrowTreeProb = TREE_REGROW_PROBABILITY;
-            float newTreeProb = random(coord);
-            if (regrowTreeProb > newTreeProb)
-            {
-                SetMaterial(cellData, MATERIAL_TREE_1);
-                return;
-            }
+            SetMaterial(cellData, MATERIAL_TREE_1);
+            timer = WILDFIRE_TIMER_NEVER;
+            return;
         }
+#endif
 
-        float windSpreadThreshold = GetWindSpreadProb(coord);
+        uint burningNeighborMask = GetBurningNeighborMask(coord);
+
+#if USE_VON_NEUMANN
+        burningNeighborMask &= VON_NEUMANN_NEIGHBOR_MASK;
+#endif
+
+#if USE_WIND_FIELD
+        // The local wind only matters next to the fire, so the field is sampled on the front alone.
+        float windSpreadThreshold = burningNeighborMask != 0u
+            ? GetWindFieldSpreadProb(coord, burningNeighborMask)
+            : spreadProbabilities[burningNeighborMask];
+#else
+        float windSpreadThreshold = spreadProbabilities[burningNeighborMask];
+#endif
+
+#if USE_SLOPE
+        if (burningNeighborMask != 0u)
+        {
+            windSpreadThreshold *= GetSlopeMultiplier(coord, burningNeighborMask);
+        }
+#endif
 
-        float windSpreadProb = random(coord + vec2(1, 1));
+        float windSpreadProb = RandomFromBlock(randomBlock, RANDOM_DRAW_WIND_SPREAD);
 
-        float fireCatchProb = random(coord);
+        float fireCatchProb = RandomFromBlock(randomBlock, RANDOM_DRAW_FIRE_CATCH);
 
         if (windSpreadThreshold > windSpreadProb || FIRE_PROB > fireCatchProb || IsImpactedByMouse(coord, cellData))
         {
-            float flammableProb = 0.0f;
-            if (cellMaterial == MATERIAL_GRASS)
-            {
-                flammableProb = FLAMMABLE_PROBABILITY_FOR_GRASS;
-            }
-            else if (cellMaterial == MATERIAL_WATER)
-            {
-                flammableProb = FLAMMABLE_PROBABILITY_FOR_WATER;
-            }
-            else if (cellMaterial == MATERIAL_BEDROCK)
-            {
-                flammableProb = FLAMMABLE_PROBABILITY_FOR_BEDROCK;
-            }
-            else if (cellMaterial == MATERIAL_TREE_1 || cellMaterial == MATERIAL_TREE_2 || cellMaterial == MATERIAL_TREE_3)
-            {
-                flammableProb = FLAMMABLE_PROBABILITY_FOR_TREE;
-            }
+            float flammableProb = cellMaterial < MATERIAL_COUNT ? flammableProbabilities[cellMaterial] : 0.0f;
 
-            float randomProb = random(coord);
+            float randomProb = RandomFromBlock(randomBlock, RANDOM_DRAW_FLAMMABLE);
 
             float currentTemperature = CalculateTemperature();
             bool isHot = currentTemperature > 25.0f;
@@ -285,28 +539,76 @@ void processCell(vec2 coord, inout vec4 cellData)
             if (flammableProb > randomProb)
             {
                 SetState(cellData, STATE_ON_FIRE);
+                timer = SampleTimer(cellIndex, BURNOUT_PROBABILITY);
             }
         }
     }
     else if (cellState == STATE_ON_FIRE)
     {
-        float randomProb = random(coord);
-        if (randomProb < 0.01f)
+        if (simulationStep >= timer)
         {
             SetState(cellData, STATE_DESTROYED);
+            timer = SampleTimer(cellIndex, GRASS_REGROW_PROBABILITY);
         }
     }
+#if USE_REGROWTH
     else if (cellState == STATE_DESTROYED)
     {
-        float regrowGrassProb = GRASS_REGROW_PROBABILITY;
-        float newGrassProb = random(coord);
-        if (regrowGrassProb > newGrassProb)
+        if (simulationStep >= timer)
         {
             SetState(cellData, STATE_NOT_ON_FIRE);
             SetMaterial(cellData, MATERIAL_GRASS);
+            timer = SampleTimer(cellIndex, TREE_REGROW_PROBABILITY);
         }
     }
+#endif
+
+}
+
+// Step one cell of the grid
+void stepCell(ivec2 cellCoord)
+{
+    vec2 coord = cellCoord;
+    uvec4 cellData = GetCellData(coord);
+
+#ifdef WILDFIRE_STATS
+    AccumulateStats(coord, cellData);
+    uvec4 statsPreviousCellData = cellData;
+#endif
+
+#ifdef WILDFIRE_EMIT_CHANGES
+    uvec2 previousCellData = cellData.rg;
+#endif
+
+    uint cellIndex = uint(cellCoord.y) * uint(GetGridSize().x) + uint(cellCoord.x);
+    uint timer = resampleTimers
+        ? ResampleTimer(cellIndex, cellData)
+        : imageLoad(timerTexture, cellCoord).r;
+    uint previousTimer = timer;
+
+    processCell(coord, cellData, timer);
+
+#ifdef WILDFIRE_STATS
+    CountIgnition(statsPreviousCellData, cellData);
+#endif
+
+    imageStore(materialStateTexture_WRITE, cellCoord, cellData);
+    if (resampleTimers || timer != previousTimer)
+    {
+        imageStore(timerTexture, cellCoord, uvec4(timer, 0u, 0u, 0u));
+    }
 
+#ifdef WILDFIRE_EMIT_CHANGES
+    // Only the fire front changes, so the atomic append is rare.
+    if (any(notEqual(cellData.rg, previousCellData)))
+    {
+        uint changeIndex = atomicAdd(changeCount, 1u);
+        if (changeIndex < uint(changes.length()))
+        {
+            changes[changeIndex] = uvec2(cellIndex, cellData.r | (cellData.g << 8));
+        }
+    }
+#endif
 }
 
 // Main function
@@ -314,10 +616,22 @@ void main()
 {
     ivec3 voxelCoord = ivec3(gl_GlobalInvocationID);
 
-    vec2 coord = voxelCoord.xy;
-    vec4 cellData = GetCellData(coord);
+#ifdef WILDFIRE_STATS
+    BeginStats();
+#endif
 
-    processCell(coord, cellData);
+#ifdef WILDFIRE_TILED
+    // Every invocation helps load the tile, even the ones past the edge of the grid.
+    LoadTile();
+#endif
 
-    imageStore(materialStateHeightTexture_WRITE, voxelCoord.xy, cellData);
-}
\ No newline at end of file
+    // Invocations past the edge of the grid (tiled kernel) still reach every barrier.
+    if (all(lessThan(voxelCoord.xy, GetGridSize())))
+    {
+        stepCell(voxelCoord.xy);
+    }
+
+#ifdef WILDFIRE_STATS
+    EndStats();
+#endif
+}
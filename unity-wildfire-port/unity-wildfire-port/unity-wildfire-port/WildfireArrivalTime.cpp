@@ -0,0 +1,151 @@
+#include "WildfireArrivalTime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Edges slower than this are dropped whatever minSpreadProbability is, which bounds the bucket count.
+static constexpr float MIN_EDGE_SPREAD_PROBABILITY = 1e-4f;
+
+// Every edge costs at least one step, so buckets one step wide never need reordering:
+// a cell taken from the current bucket cannot be improved by another cell of the same bucket.
+static constexpr float ARRIVAL_BUCKET_WIDTH = 1.0f;
+
+struct ArrivalTimeEntry
+{
+    uint32_t cellIndex;
+    float arrivalTime;
+};
+
+std::vector<float> computeWildfireArrivalTimes(const WildfireLandscape& landscape, const WildfireParameters& parameters, glm::vec2 ignitionPos, const WildfireArrivalTimeSettings& settings)
+{
+    const int width = landscape.width;
+    const int height = landscape.height;
+    const size_t pixelCount = (size_t)width * height;
+
+    std::vector<float> arrivalTimes(pixelCount, WILDFIRE_NEVER_BURNS);
+
+    ////////////////////////////////////////////////////////////////////
+    /// EDGE COSTS
+    ////////////////////////////////////////////////////////////////////
+
+    // The slowest edge worth following: p / (p + q - p q) is the chance to spread before burning out.
+    const float minSpreadProbability = glm::clamp(settings.minSpreadProbability, 0.0f, 0.999f);
+    const float minEdgeSpreadProbability = std::max(MIN_EDGE_SPREAD_PROBABILITY,
+        minSpreadProbability * BURNOUT_PROBABILITY / (1.0f - minSpreadProbability + minSpreadProbability * BURNOUT_PROBABILITY));
+
+    // The spread share of each of the 8 neighbour directions does not depend on the cell.
+    const glm::ivec2 NEIGHBOR_OFFSETS[8] = {
+        glm::ivec2(-1, -1), glm::ivec2(0, -1), glm::ivec2(1, -1),
+        glm::ivec2(-1, 0),                     glm::ivec2(1, 0),
+        glm::ivec2(-1, 1),  glm::ivec2(0, 1),  glm::ivec2(1, 1),
+    };
+
+    WildfireRuleTable ruleTable;
+    buildWildfireRuleTable(parameters, ruleTable);
+
+    float directionSpreadProbs[8];
+    float directionDistances[8];
+    for (int direction = 0; direction < 8; direction++) {
+        // The rule table looks from the unburnt cell towards its burning neighbour, so the offset is reversed.
+        directionSpreadProbs[direction] = ruleTable.spreadProbabilities[1u << GetNeighbor(-NEIGHBOR_OFFSETS[direction])];
+        directionDistances[direction] = glm::length(glm::vec2(NEIGHBOR_OFFSETS[direction])) * settings.cellSize;
+    }
+
+    const float heightToWorld = settings.heightScale / 65535.0f;
+    const float slopeSpreadFactor = parameters.bUseSlope ? settings.slopeSpreadFactor : 0.0f;
+
+    // Expected steps for the fire to cross from a burning cell to a neighbour, or a negative value if it does not.
+    auto getEdgeCost = [&](size_t fromIndex, size_t toIndex, int direction) {
+        float spreadProb = directionSpreadProbs[direction] * GetTableFlammableProbability(ruleTable, landscape.materials[toIndex]);
+
+        const float rise = ((float)landscape.heights[toIndex] - (float)landscape.heights[fromIndex]) * heightToWorld;
+        if (rise > 0.0f && slopeSpreadFactor > 0.0f) {
+            const float slope = rise / directionDistances[direction];
+            spreadProb *= 1.0f + slopeSpreadFactor * slope * slope;
+        }
+
+        spreadProb = std::min(spreadProb, 1.0f);
+        return spreadProb >= minEdgeSpreadProbability ? 1.0f / spreadProb : -1.0f;
+    };
+
+    const int bucketCount = (int)std::ceil(1.0f / minEdgeSpreadProbability / ARRIVAL_BUCKET_WIDTH) + 1;
+    std::vector<std::vector<ArrivalTimeEntry>> buckets(bucketCount);
+    size_t queuedCount = 0;
+
+    auto push = [&](uint32_t cellIndex, float arrivalTime) {
+        arrivalTimes[cellIndex] = arrivalTime;
+        buckets[(size_t)(arrivalTime / ARRIVAL_BUCKET_WIDTH) % bucketCount].push_back(ArrivalTimeEntry{ cellIndex, arrivalTime });
+        ++queuedCount;
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    /// IGNITION
+    ////////////////////////////////////////////////////////////////////
+
+    // A click tests each cell in its radius once against the cell's flammability.
+    WildfireStepContext clickContext;
+    clickContext.bIsMouseDown = true;
+    clickContext.mousePos = glm::clamp(ignitionPos, glm::vec2(0.0f), glm::vec2(1.0f));
+    clickContext.gridSize = glm::ivec2(width, height);
+
+    const glm::vec2 fireCenter = glm::vec2(clickContext.gridSize) * clickContext.mousePos;
+    const int minX = std::max(0, (int)std::floor(fireCenter.x - 10.0f));
+    const int maxX = std::min(width - 1, (int)std::ceil(fireCenter.x + 10.0f));
+    const int minY = std::max(0, (int)std::floor(fireCenter.y - 10.0f));
+    const int maxY = std::min(height - 1, (int)std::ceil(fireCenter.y + 10.0f));
+
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            const uint32_t cellIndex = (uint32_t)y * width + x;
+            if (IsImpactedByMouse(clickContext, glm::vec2(x, y)) && GetTableFlammableProbability(ruleTable, landscape.materials[cellIndex]) >= minSpreadProbability) {
+                push(cellIndex, 0.0f);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// DIAL'S ALGORITHM OVER THE BUCKETS
+    ////////////////////////////////////////////////////////////////////
+
+    for (size_t currentBucket = 0; queuedCount > 0; currentBucket++) {
+        std::vector<ArrivalTimeEntry>& bucket = buckets[currentBucket % bucketCount];
+
+        // Relaxing never adds to the bucket being drained (edges cost at least one bucket width).
+        for (size_t entryIndex = 0; entryIndex < bucket.size(); entryIndex++) {
+            const ArrivalTimeEntry entry = bucket[entryIndex];
+            --queuedCount;
+
+            // Stale entry, the cell was reached sooner through another path.
+            if (entry.arrivalTime > arrivalTimes[entry.cellIndex] || entry.arrivalTime > settings.maxArrivalTime) {
+                continue;
+            }
+
+            const int x = (int)(entry.cellIndex % width);
+            const int y = (int)(entry.cellIndex / width);
+
+            for (int direction = 0; direction < 8; direction++) {
+                const int neighborX = x + NEIGHBOR_OFFSETS[direction].x;
+                const int neighborY = y + NEIGHBOR_OFFSETS[direction].y;
+                if (neighborX < 0 || neighborY < 0 || neighborX >= width || neighborY >= height) {
+                    continue;
+                }
+
+                const uint32_t neighborIndex = (uint32_t)neighborY * width + neighborX;
+                const float edgeCost = getEdgeCost(entry.cellIndex, neighborIndex, direction);
+                if (edgeCost < 0.0f) {
+                    continue;
+                }
+
+                const float neighborArrivalTime = entry.arrivalTime + edgeCost;
+                if (neighborArrivalTime < arrivalTimes[neighborIndex] && neighborArrivalTime <= settings.maxArrivalTime) {
+                    push(neighborIndex, neighborArrivalTime);
+                }
+            }
+        }
+
+        bucket.clear();
+    }
+
+    return arrivalTimes;
+}
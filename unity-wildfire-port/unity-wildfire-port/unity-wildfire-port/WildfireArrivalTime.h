@@ -0,0 +1,52 @@
+#ifndef WILDFIRE_ARRIVAL_TIME_H
+#define WILDFIRE_ARRIVAL_TIME_H
+
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+
+#include <glm/glm.hpp>
+
+#include <limits>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Deterministic minimum travel time engine. Instead of stepping the stochastic rules until
+// the fire stops, fire spread is treated as a shortest path problem over the 8-connected
+// grid and the arrival time of every cell is computed in one pass.
+//
+// The edge from a burning cell to a neighbour costs the expected number of steps until the
+// neighbour catches fire from it alone under processCell's rules: 1 / p, where p is the
+// neighbour's wind-weighted spread share (GetNeighborSpreadProb) times its flammability,
+// scaled up for upslope spread. Edges which are more likely to burn out than to spread are
+// dropped, which is what stops the fire at grass and water.
+//
+// The wind, neighbourhood, flammability and slope switches come from the parameters, like a
+// stepped run. There are no random numbers, so the seed and spontaneous ignition do not apply.
+//
+// ----------------------------------------------------------------------------
+
+// Arrival time of cells the fire never reaches.
+constexpr float WILDFIRE_NEVER_BURNS = std::numeric_limits<float>::infinity();
+
+struct WildfireArrivalTimeSettings
+{
+    // Scales of the height plane and the upslope spread model (see WildfireLandscape.h).
+    // A slopeSpreadFactor of 0, or parameters.bUseSlope off, ignores the terrain.
+    float heightScale = WILDFIRE_HEIGHT_SCALE;
+    float cellSize = WILDFIRE_CELL_SIZE;
+    float slopeSpreadFactor = WILDFIRE_SLOPE_SPREAD_FACTOR;
+
+    // An edge is only used if the fire is at least this likely to cross it before the burning
+    // cell burns out.
+    float minSpreadProbability = 0.5f;
+
+    // Stop once every remaining cell would be reached later than this (in steps).
+    float maxArrivalTime = WILDFIRE_NEVER_BURNS;
+};
+
+// Arrival time (in steps) of the fire at every cell, row major like the grid, for an ignition
+// at a normalized (0-1) grid position with the same radius as a mouse click.
+std::vector<float> computeWildfireArrivalTimes(const WildfireLandscape& landscape, const WildfireParameters& parameters, glm::vec2 ignitionPos, const WildfireArrivalTimeSettings& settings = WildfireArrivalTimeSettings());
+
+#endif
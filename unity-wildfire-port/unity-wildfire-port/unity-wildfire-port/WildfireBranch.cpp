@@ -0,0 +1,311 @@
+#include "WildfireBranch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+WildfireBranch::WildfireBranch(const WildfireLandscape& landscape, WildfireThreadPool& threadPool)
+    : width(landscape.width),
+      height(landscape.height),
+      tileCountX((landscape.width + TILE_SIZE - 1) / TILE_SIZE),
+      tileCountY((landscape.height + TILE_SIZE - 1) / TILE_SIZE),
+      slopeFactors(std::make_shared<const std::vector<uint32_t>>(computeWildfireSlopeFactors(landscape))),
+      threadPool(&threadPool)
+{
+    std::vector<WildfireCell> cells(landscape.materials.size());
+    for (size_t pixel_index = 0; pixel_index < cells.size(); pixel_index++) {
+        cells[pixel_index] = WildfireCell{ landscape.materials[pixel_index], STATE_NOT_ON_FIRE };
+    }
+
+    setCells(cells);
+}
+
+void WildfireBranch::setCells(const std::vector<WildfireCell>& newCells)
+{
+    if (newCells.size() != (size_t)width * height) {
+        return;
+    }
+
+    tiles.assign((size_t)tileCountX * tileCountY, nullptr);
+    burningTiles.clear();
+    burningCellCount = 0;
+    destroyedCellCount = 0;
+
+    for (size_t tileIndex = 0; tileIndex < tiles.size(); tileIndex++) {
+        std::shared_ptr<WildfireBranchTile> tile = std::make_shared<WildfireBranchTile>();
+
+        // Padding cells outside the grid are never stepped.
+        const int startX = (int)(tileIndex % tileCountX) * TILE_SIZE;
+        const int startY = (int)(tileIndex / tileCountX) * TILE_SIZE;
+        for (int localY = 0; localY < TILE_SIZE; localY++) {
+            for (int localX = 0; localX < TILE_SIZE; localX++) {
+                const int x = startX + localX;
+                const int y = startY + localY;
+                const WildfireCell cell = (x < width && y < height)
+                    ? newCells[(size_t)y * width + x]
+                    : WildfireCell{ MATERIAL_WATER, STATE_NOT_ON_FIRE };
+
+                tile->cells[localY * TILE_SIZE + localX] = cell;
+                tile->burningCellCount += GetState(cell) == STATE_ON_FIRE;
+                tile->destroyedCellCount += GetState(cell) == STATE_DESTROYED;
+            }
+        }
+
+        if (tile->burningCellCount > 0) {
+            burningTiles.push_back((uint32_t)tileIndex);
+        }
+        burningCellCount += tile->burningCellCount;
+        destroyedCellCount += tile->destroyedCellCount;
+
+        tiles[tileIndex] = std::move(tile);
+    }
+
+    candidateStamps.assign(tiles.size(), 0);
+    currentStamp = 0;
+}
+
+std::vector<WildfireCell> WildfireBranch::getCells() const
+{
+    std::vector<WildfireCell> cells((size_t)width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            cells[(size_t)y * width + x] = getCell(x, y);
+        }
+    }
+    return cells;
+}
+
+WildfireCell WildfireBranch::getCell(int x, int y) const
+{
+    const size_t tileIndex = (size_t)(y / TILE_SIZE) * tileCountX + (x / TILE_SIZE);
+    return tiles[tileIndex]->cells[(y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE)];
+}
+
+WildfireBranchTile& WildfireBranch::getMutableTile(size_t tileIndex)
+{
+    // Only this branch holds a tile with a single owner, so it can be written in place.
+    if (tiles[tileIndex].use_count() > 1) {
+        tiles[tileIndex] = std::make_shared<WildfireBranchTile>(*tiles[tileIndex]);
+    }
+    return *tiles[tileIndex];
+}
+
+void WildfireBranch::ignite(glm::vec2 normalizedPos)
+{
+    bIsIgnitionPending = true;
+    pendingIgnitionPos = glm::clamp(normalizedPos, glm::vec2(0.0f), glm::vec2(1.0f));
+}
+
+void WildfireBranch::cutFirebreak(glm::ivec2 minCoord, glm::ivec2 maxCoord)
+{
+    minCoord = glm::max(minCoord, glm::ivec2(0));
+    maxCoord = glm::min(maxCoord, glm::ivec2(width - 1, height - 1));
+
+    for (int tileY = minCoord.y / TILE_SIZE; tileY <= maxCoord.y / TILE_SIZE && minCoord.y <= maxCoord.y; tileY++) {
+        for (int tileX = minCoord.x / TILE_SIZE; tileX <= maxCoord.x / TILE_SIZE && minCoord.x <= maxCoord.x; tileX++) {
+            const size_t tileIndex = (size_t)tileY * tileCountX + tileX;
+            WildfireBranchTile& tile = getMutableTile(tileIndex);
+
+            const int startX = std::max(minCoord.x, tileX * TILE_SIZE);
+            const int startY = std::max(minCoord.y, tileY * TILE_SIZE);
+            const int endX = std::min(maxCoord.x + 1, (tileX + 1) * TILE_SIZE);
+            const int endY = std::min(maxCoord.y + 1, (tileY + 1) * TILE_SIZE);
+
+            for (int y = startY; y < endY; y++) {
+                for (int x = startX; x < endX; x++) {
+                    WildfireCell& cell = tile.cells[(y - tileY * TILE_SIZE) * TILE_SIZE + (x - tileX * TILE_SIZE)];
+
+                    // Cells which are already burning keep burning.
+                    if (GetState(cell) == STATE_NOT_ON_FIRE) {
+                        SetState(cell, STATE_DESTROYED);
+                        ++tile.destroyedCellCount;
+                        ++destroyedCellCount;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void WildfireBranch::addCandidateTile(int tileX, int tileY)
+{
+    if (tileX < 0 || tileY < 0 || tileX >= tileCountX || tileY >= tileCountY) {
+        return;
+    }
+
+    const uint32_t tileIndex = (uint32_t)tileY * tileCountX + tileX;
+    if (candidateStamps[tileIndex] != currentStamp) {
+        candidateStamps[tileIndex] = currentStamp;
+        candidateTiles.push_back(tileIndex);
+    }
+}
+
+int WildfireBranch::getCellState(int x, int y) const
+{
+    // Out of bounds neighbours read as not on fire, just like imageLoad outside the image.
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return STATE_NOT_ON_FIRE;
+    }
+
+    return GetState(getCell(x, y));
+}
+
+void WildfireBranch::step()
+{
+    const bool bIsMouseDown = bIsIgnitionPending;
+    bIsIgnitionPending = false;
+
+    WildfireParameters stepParameters = parameters;
+    stepParameters.treeRegrowProbability = 0.0f;
+    stepParameters.grassRegrowProbability = 0.0f;
+
+    WildfireStepContext context;
+    context.step = (uint32_t)stepCount;
+    context.bIsMouseDown = bIsMouseDown;
+    context.mousePos = pendingIgnitionPos;
+    context.gridSize = glm::ivec2(width, height);
+    context.temperature = CalculateTemperature(stepParameters, context.step);
+
+    ruleTableCache.update(stepParameters);
+    context.ruleTable = &ruleTableCache.get();
+
+    if (stepParameters.bUseSlope) {
+        context.slopeFactors = slopeFactors->data();
+    }
+
+    // Stamps tell which tiles are candidates this step without clearing a per-tile array.
+    if (++currentStamp == 0) {
+        std::fill(candidateStamps.begin(), candidateStamps.end(), 0);
+        currentStamp = 1;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// GATHER THE TILES WHICH CAN CHANGE
+    ////////////////////////////////////////////////////////////////////
+
+    candidateTiles.clear();
+    if (stepParameters.fireProbability > 0.0f) {
+        // Spontaneous ignition can happen anywhere. Tiles which do not change are still shared.
+        for (int tileY = 0; tileY < tileCountY; tileY++) {
+            for (int tileX = 0; tileX < tileCountX; tileX++) {
+                addCandidateTile(tileX, tileY);
+            }
+        }
+    }
+
+    // Fire spreads one cell per step, so it can only enter a tile from a neighbouring tile.
+    for (uint32_t tileIndex : burningTiles) {
+        const int tileX = (int)(tileIndex % tileCountX);
+        const int tileY = (int)(tileIndex / tileCountX);
+
+        for (int j = -1; j <= 1; j++) {
+            for (int i = -1; i <= 1; i++) {
+                addCandidateTile(tileX + i, tileY + j);
+            }
+        }
+    }
+
+    if (bIsMouseDown) {
+        const glm::vec2 fireCenter = glm::vec2(context.gridSize) * context.mousePos;
+        const int minTileX = (int)std::floor((fireCenter.x - 10.0f) / TILE_SIZE);
+        const int maxTileX = (int)std::floor((fireCenter.x + 10.0f) / TILE_SIZE);
+        const int minTileY = (int)std::floor((fireCenter.y - 10.0f) / TILE_SIZE);
+        const int maxTileY = (int)std::floor((fireCenter.y + 10.0f) / TILE_SIZE);
+
+        for (int tileY = minTileY; tileY <= maxTileY; tileY++) {
+            for (int tileX = minTileX; tileX <= maxTileX; tileX++) {
+                addCandidateTile(tileX, tileY);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// STEP THE CANDIDATES INTO SCRATCH TILES
+    ////////////////////////////////////////////////////////////////////
+
+    const size_t cellsPerTile = (size_t)TILE_SIZE * TILE_SIZE;
+
+    std::vector<WildfireCell> scratchCells(candidateTiles.size() * cellsPerTile);
+    std::vector<uint8_t> scratchIsChanged(candidateTiles.size());
+
+    dispatchWildfireRules<WILDFIRE_RULE_ALL & ~WILDFIRE_RULE_TIMERS>(getWildfireRules(stepParameters, context), [&](auto rules) {
+        threadPool->parallelFor(candidateTiles.size(), [&](size_t candidateIndex) {
+            bool bIsChanged = false;
+            stepTile<decltype(rules)::value>(stepParameters, context, candidateTiles[candidateIndex], &scratchCells[candidateIndex * cellsPerTile], bIsChanged);
+            scratchIsChanged[candidateIndex] = bIsChanged;
+        });
+    });
+
+    ////////////////////////////////////////////////////////////////////
+    /// WRITE BACK THE CHANGED TILES
+    ////////////////////////////////////////////////////////////////////
+
+    // Every burning tile was a candidate, so this finds all of them.
+    burningTiles.clear();
+    for (size_t candidateIndex = 0; candidateIndex < candidateTiles.size(); candidateIndex++) {
+        const uint32_t tileIndex = candidateTiles[candidateIndex];
+
+        if (scratchIsChanged[candidateIndex]) {
+            WildfireBranchTile& tile = getMutableTile(tileIndex);
+            std::memcpy(tile.cells, &scratchCells[candidateIndex * cellsPerTile], sizeof(tile.cells));
+
+            burningCellCount -= tile.burningCellCount;
+            destroyedCellCount -= tile.destroyedCellCount;
+            tile.burningCellCount = 0;
+            tile.destroyedCellCount = 0;
+            for (const WildfireCell& cell : tile.cells) {
+                tile.burningCellCount += GetState(cell) == STATE_ON_FIRE;
+                tile.destroyedCellCount += GetState(cell) == STATE_DESTROYED;
+            }
+            burningCellCount += tile.burningCellCount;
+            destroyedCellCount += tile.destroyedCellCount;
+        }
+
+        if (tiles[tileIndex]->burningCellCount > 0) {
+            burningTiles.push_back(tileIndex);
+        }
+    }
+
+    ++stepCount;
+}
+
+template <uint32_t Rules>
+void WildfireBranch::stepTile(const WildfireParameters& stepParameters, const WildfireStepContext& context, size_t tileIndex, WildfireCell* outCells, bool& outIsChanged) const
+{
+    const WildfireCell* cells = tiles[tileIndex]->cells;
+
+    const int startX = (int)(tileIndex % tileCountX) * TILE_SIZE;
+    const int startY = (int)(tileIndex / tileCountX) * TILE_SIZE;
+
+    auto getNeighborState = [&](int x, int y) {
+        // Most neighbours lie in the same tile.
+        const int localX = x - startX;
+        const int localY = y - startY;
+        if (localX >= 0 && localY >= 0 && localX < TILE_SIZE && localY < TILE_SIZE) {
+            return (x < width && y < height) ? GetState(cells[localY * TILE_SIZE + localX]) : (int)STATE_NOT_ON_FIRE;
+        }
+        return getCellState(x, y);
+    };
+
+    // Padding cells outside the grid keep their state.
+    std::memcpy(outCells, cells, sizeof(WildfireBranchTile::cells));
+
+    outIsChanged = false;
+
+    const int endX = std::min(startX + TILE_SIZE, width);
+    const int endY = std::min(startY + TILE_SIZE, height);
+
+    for (int y = startY; y < endY; y++) {
+        for (int x = startX; x < endX; x++) {
+            const int localIndex = (y - startY) * TILE_SIZE + (x - startX);
+
+            WildfireCell cellData = cells[localIndex];
+            processCell<Rules>(stepParameters, context, glm::ivec2(x, y), cellData, getNeighborState);
+
+            if (cellData.state != cells[localIndex].state || cellData.material != cells[localIndex].material) {
+                outCells[localIndex] = cellData;
+                outIsChanged = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef WILDFIRE_BRANCH_H
+#define WILDFIRE_BRANCH_H
+
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+#include "WildfireThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One 64x64 tile of a branch's grid. Tiles are immutable while shared between branches.
+struct WildfireBranchTile
+{
+    static constexpr int SIZE = 64;
+
+    WildfireCell cells[SIZE * SIZE];
+    uint32_t burningCellCount = 0;
+    uint32_t destroyedCellCount = 0;
+};
+
+// A what-if branch of a running simulation. The grid is held in tiles shared copy-on-write
+// between branches: fork() only copies the tile pointers, and a step duplicates just the tiles
+// it changes, so many branches of one fire cost little more than the fire's neighbourhood each.
+// The static height and slope planes and the thread pool are shared by every fork.
+//
+// Branches answer "what if the wind shifts / we cut a break here" for the current fire, so
+// regrowth is disabled (like WildfireEnsemble) and burnout is rolled every step. Without
+// spontaneous ignition only tiles near the fire are stepped.
+class WildfireBranch
+{
+public:
+    static constexpr int TILE_SIZE = WildfireBranchTile::SIZE;
+
+    // The thread pool steps the tiles of this branch and of every fork, and must outlive them.
+    WildfireBranch(const WildfireLandscape& landscape, WildfireThreadPool& threadPool);
+
+    // A branch with the same grid, parameters and step count. Costs one pointer copy per tile.
+    WildfireBranch fork() const { return *this; }
+
+    // Continue from the cells of another engine (e.g. WildfireEngine::getCells() or a snapshot).
+    void setCells(const std::vector<WildfireCell>& newCells);
+    std::vector<WildfireCell> getCells() const;
+    WildfireCell getCell(int x, int y) const;
+
+    // Advance the grid by one step. Fire, ignitions and parameters are per branch.
+    void step();
+
+    // Start a fire around a normalized (0-1) grid position on the next step(), like a mouse click.
+    void ignite(glm::vec2 normalizedPos);
+
+    // Burn out every cell of the rectangle [minCoord, maxCoord] ahead of the fire, so it has
+    // no fuel left to cross it.
+    void cutFirebreak(glm::ivec2 minCoord, glm::ivec2 maxCoord);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStepCount() const { return stepCount; }
+    void setStepCount(int newStepCount) { stepCount = newStepCount; }
+
+    size_t getBurningCellCount() const { return burningCellCount; }
+    size_t getDestroyedCellCount() const { return destroyedCellCount; }
+
+    // The tiles of the grid, to count how many distinct tiles a set of branches holds.
+    const std::vector<std::shared_ptr<WildfireBranchTile>>& getTiles() const { return tiles; }
+
+    WildfireParameters parameters;
+
+private:
+    // The tile, duplicated first if another branch still shares it.
+    WildfireBranchTile& getMutableTile(size_t tileIndex);
+    void addCandidateTile(int tileX, int tileY);
+    int getCellState(int x, int y) const;
+    template <uint32_t Rules>
+    void stepTile(const WildfireParameters& stepParameters, const WildfireStepContext& context, size_t tileIndex, WildfireCell* outCells, bool& outIsChanged) const;
+
+    int width;
+    int height;
+    int tileCountX;
+    int tileCountY;
+
+    std::shared_ptr<const std::vector<uint32_t>> slopeFactors;
+    WildfireThreadPool* threadPool;
+
+    std::vector<std::shared_ptr<WildfireBranchTile>> tiles;
+
+    // Tiles with at least one burning cell.
+    std::vector<uint32_t> burningTiles;
+
+    std::vector<uint32_t> candidateTiles;
+    std::vector<uint32_t> candidateStamps;
+    uint32_t currentStamp = 0;
+
+    size_t burningCellCount = 0;
+    size_t destroyedCellCount = 0;
+    int stepCount = 0;
+
+    bool bIsIgnitionPending = false;
+    glm::vec2 pendingIgnitionPos = glm::vec2(0.0f, 0.0f);
+
+    // Rebuilt whenever the wind or a flammable probability changes.
+    WildfireRuleTableCache ruleTableCache;
+};
+
+#endif
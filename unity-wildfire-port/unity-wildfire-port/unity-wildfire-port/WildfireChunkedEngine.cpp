@@ -0,0 +1,206 @@
+#include "WildfireChunkedEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+WildfireChunkedEngine::WildfireChunkedEngine(WildfireGridFile& gridFile, unsigned int threadCount)
+    : gridFile(gridFile),
+      tileSize(gridFile.getTileSize()),
+      threadPool(threadCount)
+{
+    // The tile index knows where the fire is, so the state plane is not read here.
+    for (size_t tileIndex = 0; tileIndex < gridFile.getTileCount(); tileIndex++) {
+        const WildfireGridTile& tile = gridFile.getTile(tileIndex);
+        if (tile.burningCellCount > 0) {
+            burningTiles.push_back((uint32_t)tileIndex);
+        }
+
+        burningCellCount += tile.burningCellCount;
+        destroyedCellCount += tile.destroyedCellCount;
+    }
+
+    candidateStamps.assign(gridFile.getTileCount(), 0);
+}
+
+void WildfireChunkedEngine::ignite(glm::vec2 normalizedPos)
+{
+    bIsIgnitionPending = true;
+    pendingIgnitionPos = glm::clamp(normalizedPos, glm::vec2(0.0f), glm::vec2(1.0f));
+}
+
+void WildfireChunkedEngine::addCandidateTile(int tileX, int tileY)
+{
+    if (tileX < 0 || tileY < 0 || tileX >= gridFile.getTileCountX() || tileY >= gridFile.getTileCountY()) {
+        return;
+    }
+
+    const uint32_t tileIndex = (uint32_t)tileY * gridFile.getTileCountX() + tileX;
+
+    // Fire cannot enter an all water tile (unless water was made flammable), but burning tiles always have to finish burning.
+    const WildfireGridTile& tile = gridFile.getTile(tileIndex);
+    if (tile.burnableCellCount == 0 && tile.burningCellCount == 0 && parameters.flammableProbabilityForWater <= 0.0f) {
+        return;
+    }
+
+    if (candidateStamps[tileIndex] != currentStamp) {
+        candidateStamps[tileIndex] = currentStamp;
+        candidateTiles.push_back(tileIndex);
+    }
+}
+
+int WildfireChunkedEngine::getCellState(int x, int y) const
+{
+    // Out of bounds neighbours read as not on fire, just like imageLoad outside the image.
+    if (x < 0 || y < 0 || x >= gridFile.getWidth() || y >= gridFile.getHeight()) {
+        return STATE_NOT_ON_FIRE;
+    }
+
+    const size_t tileIndex = (size_t)(y / tileSize) * gridFile.getTileCountX() + (x / tileSize);
+    return gridFile.getStateTile(tileIndex)[(y % tileSize) * tileSize + (x % tileSize)];
+}
+
+void WildfireChunkedEngine::step()
+{
+    const bool bIsMouseDown = bIsIgnitionPending;
+    bIsIgnitionPending = false;
+
+    WildfireParameters stepParameters = parameters;
+    stepParameters.fireProbability = 0.0f;
+    stepParameters.treeRegrowProbability = 0.0f;
+    stepParameters.grassRegrowProbability = 0.0f;
+
+    WildfireStepContext context;
+    context.step = gridFile.getStepCount();
+    context.bIsMouseDown = bIsMouseDown;
+    context.mousePos = pendingIgnitionPos;
+    context.gridSize = glm::ivec2(gridFile.getWidth(), gridFile.getHeight());
+    context.temperature = CalculateTemperature(stepParameters, context.step);
+
+    ruleTableCache.update(stepParameters);
+    context.ruleTable = &ruleTableCache.get();
+
+    // Stamps tell which tiles are candidates this step without clearing a per-tile array.
+    if (++currentStamp == 0) {
+        std::fill(candidateStamps.begin(), candidateStamps.end(), 0);
+        currentStamp = 1;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// GATHER THE TILES WHICH CAN CHANGE
+    ////////////////////////////////////////////////////////////////////
+
+    // Fire spreads one cell per step, so it can only enter a tile from a neighbouring tile.
+    candidateTiles.clear();
+    for (uint32_t tileIndex : burningTiles) {
+        const int tileX = (int)(tileIndex % gridFile.getTileCountX());
+        const int tileY = (int)(tileIndex / gridFile.getTileCountX());
+
+        for (int j = -1; j <= 1; j++) {
+            for (int i = -1; i <= 1; i++) {
+                addCandidateTile(tileX + i, tileY + j);
+            }
+        }
+    }
+
+    if (bIsMouseDown) {
+        const glm::vec2 fireCenter = glm::vec2(context.gridSize) * context.mousePos;
+        const int minTileX = (int)std::floor((fireCenter.x - 10.0f) / tileSize);
+        const int maxTileX = (int)std::floor((fireCenter.x + 10.0f) / tileSize);
+        const int minTileY = (int)std::floor((fireCenter.y - 10.0f) / tileSize);
+        const int maxTileY = (int)std::floor((fireCenter.y + 10.0f) / tileSize);
+
+        for (int tileY = minTileY; tileY <= maxTileY; tileY++) {
+            for (int tileX = minTileX; tileX <= maxTileX; tileX++) {
+                addCandidateTile(tileX, tileY);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// STEP THE CANDIDATES INTO RESIDENT BUFFERS
+    ////////////////////////////////////////////////////////////////////
+
+    const size_t cellsPerTile = (size_t)tileSize * tileSize;
+
+    std::vector<uint8_t> residentStates(candidateTiles.size() * cellsPerTile);
+    std::vector<uint32_t> residentBurningCounts(candidateTiles.size());
+    std::vector<uint32_t> residentDestroyedCounts(candidateTiles.size());
+
+    dispatchWildfireRules<WILDFIRE_RULE_ALL & ~WILDFIRE_RULE_TIMERS>(getWildfireRules(stepParameters, context), [&](auto rules) {
+        threadPool.parallelFor(candidateTiles.size(), [&](size_t candidateIndex) {
+            stepTile<decltype(rules)::value>(stepParameters, context, candidateTiles[candidateIndex], &residentStates[candidateIndex * cellsPerTile],
+                residentBurningCounts[candidateIndex], residentDestroyedCounts[candidateIndex]);
+        });
+    });
+
+    ////////////////////////////////////////////////////////////////////
+    /// WRITE BACK AND UPDATE THE TILE INDEX
+    ////////////////////////////////////////////////////////////////////
+
+    burningTiles.clear();
+    for (size_t candidateIndex = 0; candidateIndex < candidateTiles.size(); candidateIndex++) {
+        const uint32_t tileIndex = candidateTiles[candidateIndex];
+        WildfireGridTile& tile = gridFile.getTile(tileIndex);
+
+        std::memcpy(gridFile.getStateTile(tileIndex), &residentStates[candidateIndex * cellsPerTile], cellsPerTile);
+
+        burningCellCount += residentBurningCounts[candidateIndex];
+        burningCellCount -= tile.burningCellCount;
+        destroyedCellCount += residentDestroyedCounts[candidateIndex];
+        destroyedCellCount -= tile.destroyedCellCount;
+
+        tile.burningCellCount = residentBurningCounts[candidateIndex];
+        tile.destroyedCellCount = residentDestroyedCounts[candidateIndex];
+
+        // Every burning tile was a candidate, so this finds all of them.
+        if (tile.burningCellCount > 0) {
+            burningTiles.push_back(tileIndex);
+        }
+    }
+
+    lastStepResidentTileCount = candidateTiles.size();
+    gridFile.setStepCount(context.step + 1);
+}
+
+template <uint32_t Rules>
+void WildfireChunkedEngine::stepTile(const WildfireParameters& stepParameters, const WildfireStepContext& context, size_t tileIndex, uint8_t* outStates, uint32_t& outBurningCount, uint32_t& outDestroyedCount) const
+{
+    const uint8_t* materials = gridFile.getMaterialTile(tileIndex);
+    const uint8_t* states = gridFile.getStateTile(tileIndex);
+
+    const int startX = (int)(tileIndex % gridFile.getTileCountX()) * tileSize;
+    const int startY = (int)(tileIndex / gridFile.getTileCountX()) * tileSize;
+
+    auto getNeighborState = [&](int x, int y) {
+        // Most neighbours lie in the same tile.
+        const int localX = x - startX;
+        const int localY = y - startY;
+        if (localX >= 0 && localY >= 0 && localX < tileSize && localY < tileSize) {
+            return (x < context.gridSize.x && y < context.gridSize.y) ? (int)states[localY * tileSize + localX] : (int)STATE_NOT_ON_FIRE;
+        }
+        return getCellState(x, y);
+    };
+
+    // Padding cells outside the grid keep their state.
+    std::memcpy(outStates, states, (size_t)tileSize * tileSize);
+
+    outBurningCount = 0;
+    outDestroyedCount = 0;
+
+    const int endX = std::min(startX + tileSize, context.gridSize.x);
+    const int endY = std::min(startY + tileSize, context.gridSize.y);
+
+    for (int y = startY; y < endY; y++) {
+        for (int x = startX; x < endX; x++) {
+            const int localIndex = (y - startY) * tileSize + (x - startX);
+
+            WildfireCell cellData = WildfireCell{ materials[localIndex], states[localIndex] };
+            processCell<Rules>(stepParameters, context, glm::ivec2(x, y), cellData, getNeighborState);
+            outStates[localIndex] = cellData.state;
+
+            outBurningCount += cellData.state == STATE_ON_FIRE;
+            outDestroyedCount += cellData.state == STATE_DESTROYED;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef WILDFIRE_CHUNKED_ENGINE_H
+#define WILDFIRE_CHUNKED_ENGINE_H
+
+#include "WildfireGridFile.h"
+#include "WildfireRules.h"
+#include "WildfireThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Steps a memory-mapped WildfireGridFile in place. Only tiles with fire in or next to them
+// (and tiles under an ignition) are read and written, so for a state-scale domain only the
+// fire's neighbourhood is ever resident. Each stepped tile is computed into a resident buffer
+// from the mapped states, and the buffers are written back once every tile is done.
+//
+// Spontaneous ignition and regrowth would touch every tile each step, so they are disabled:
+// this engine spreads fires from ignitions.
+// The terrain slope is ignored as well: the grid file has no slope factor plane, and there is
+// no timer plane, so burnout is rolled every step.
+class WildfireChunkedEngine
+{
+public:
+    // threadCount == 0 uses every hardware thread.
+    explicit WildfireChunkedEngine(WildfireGridFile& gridFile, unsigned int threadCount = 0);
+
+    // Advance the grid by one step. The step counter is stored in the file.
+    void step();
+
+    // Start a fire around a normalized (0-1) grid position on the next step(), like a mouse click.
+    void ignite(glm::vec2 normalizedPos);
+
+    int getWidth() const { return gridFile.getWidth(); }
+    int getHeight() const { return gridFile.getHeight(); }
+    int getStepCount() const { return (int)gridFile.getStepCount(); }
+    unsigned int getThreadCount() const { return threadPool.getThreadCount(); }
+
+    // Number of tiles read and written by the last step.
+    size_t getLastStepResidentTileCount() const { return lastStepResidentTileCount; }
+
+    size_t getBurningCellCount() const { return burningCellCount; }
+    size_t getDestroyedCellCount() const { return destroyedCellCount; }
+
+    WildfireParameters parameters;
+
+private:
+    void addCandidateTile(int tileX, int tileY);
+    template <uint32_t Rules>
+    void stepTile(const WildfireParameters& stepParameters, const WildfireStepContext& context, size_t tileIndex, uint8_t* outStates, uint32_t& outBurningCount, uint32_t& outDestroyedCount) const;
+    int getCellState(int x, int y) const;
+
+    WildfireGridFile& gridFile;
+
+    int tileSize;
+
+    // Tiles with at least one burning cell, taken from the tile index.
+    std::vector<uint32_t> burningTiles;
+
+    std::vector<uint32_t> candidateTiles;
+    std::vector<uint32_t> candidateStamps;
+    uint32_t currentStamp = 0;
+
+    size_t burningCellCount = 0;
+    size_t destroyedCellCount = 0;
+    size_t lastStepResidentTileCount = 0;
+
+    bool bIsIgnitionPending = false;
+    glm::vec2 pendingIgnitionPos = glm::vec2(0.0f, 0.0f);
+
+    // Rebuilt whenever the wind or a flammable probability changes.
+    WildfireRuleTableCache ruleTableCache;
+
+    WildfireThreadPool threadPool;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef WILDFIRE_DEFINITIONS_H
+#define WILDFIRE_DEFINITIONS_H
+
+////////////////////////////////////////////////////////////////////
+/// MATERIALS
+////////////////////////////////////////////////////////////////////
+
+#define MATERIAL_GRASS 0
+#define MATERIAL_WATER 1
+#define MATERIAL_BEDROCK 2
+#define MATERIAL_TREE_1 3
+#define MATERIAL_TREE_2 4
+#define MATERIAL_TREE_3 5
+#define MATERIAL_COUNT 6
+
+////////////////////////////////////////////////////////////////////
+/// STATES
+////////////////////////////////////////////////////////////////////
+
+#define STATE_NOT_ON_FIRE 0
+#define STATE_ON_FIRE 1
+#define STATE_DESTROYED 2
+
+#endif
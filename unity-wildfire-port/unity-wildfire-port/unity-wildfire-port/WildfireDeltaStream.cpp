@@ -0,0 +1,88 @@
+#include "WildfireDeltaStream.h"
+
+#include <algorithm>
+#include <iostream>
+
+bool WildfireDeltaStreamWriter::open(const char* path, int width, int height)
+{
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create delta stream: " << path << std::endl;
+        return false;
+    }
+
+    WildfireDeltaStreamHeader header = {};
+    header.magic = WILDFIRE_DELTA_STREAM_MAGIC;
+    header.version = WILDFIRE_DELTA_STREAM_VERSION;
+    header.width = width;
+    header.height = height;
+    file.write((const char*)&header, sizeof(header));
+    file.flush();
+
+    return true;
+}
+
+void WildfireDeltaStreamWriter::close()
+{
+    if (isOpen()) {
+        file.close();
+    }
+}
+
+void WildfireDeltaStreamWriter::writeFrame(uint32_t step, uint32_t flags, const WildfireCellChange* changes, size_t changeCount, size_t droppedCount)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    // GPU workgroups append in any order. Sorted frames compress better and diff cleanly between runs.
+    sortedChanges.assign(changes, changes + changeCount);
+    std::sort(sortedChanges.begin(), sortedChanges.end(), [](const WildfireCellChange& a, const WildfireCellChange& b) { return a.index < b.index; });
+
+    WildfireDeltaFrameHeader frame = {};
+    frame.step = step;
+    frame.flags = flags | (droppedCount > 0 ? DELTA_FRAME_OVERFLOWED : 0);
+    frame.changeCount = (uint32_t)changeCount;
+    frame.droppedCount = (uint32_t)droppedCount;
+
+    file.write((const char*)&frame, sizeof(frame));
+    file.write((const char*)sortedChanges.data(), (std::streamsize)(sortedChanges.size() * sizeof(WildfireCellChange)));
+    file.flush();
+}
+
+bool WildfireDeltaStreamReader::open(const char* path)
+{
+    file.open(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open delta stream: " << path << std::endl;
+        return false;
+    }
+
+    file.read((char*)&header, sizeof(header));
+    if (!file || header.magic != WILDFIRE_DELTA_STREAM_MAGIC || header.version != WILDFIRE_DELTA_STREAM_VERSION) {
+        std::cerr << "Not a valid delta stream: " << path << std::endl;
+        file.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool WildfireDeltaStreamReader::readFrame(WildfireDeltaFrameHeader& outFrame, std::vector<WildfireCellChange>& outChanges)
+{
+    if (!file.read((char*)&outFrame, sizeof(outFrame))) {
+        return false;
+    }
+
+    outChanges.resize(outFrame.changeCount);
+    return (bool)file.read((char*)outChanges.data(), (std::streamsize)(outChanges.size() * sizeof(WildfireCellChange)));
+}
+
+void applyWildfireCellChanges(std::vector<WildfireCell>& cells, const std::vector<WildfireCellChange>& changes)
+{
+    for (const WildfireCellChange& change : changes) {
+        if (change.index < cells.size()) {
+            cells[change.index] = change.cell;
+        }
+    }
+}
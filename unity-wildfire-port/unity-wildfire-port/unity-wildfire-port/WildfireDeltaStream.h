@@ -0,0 +1,91 @@
+#ifndef WILDFIRE_DELTA_STREAM_H
+#define WILDFIRE_DELTA_STREAM_H
+
+#include "WildfireRules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Stream of the cells each step changed, for consumers which only care about fire activity.
+// A frame costs a 16 byte header plus 8 bytes per changed cell, so the output tracks the
+// fire front instead of the grid size. The stream can be written to a file or a named pipe.
+//
+// Layout (little endian):
+//   WildfireDeltaStreamHeader
+//   per step: WildfireDeltaFrameHeader, then changeCount WildfireCellChange records
+//             (ascending cell index)
+//
+// Applying every frame in order to the grid the stream started from gives the current grid.
+//
+// ----------------------------------------------------------------------------
+
+// The producer ran out of room for the step's changes and droppedCount of them are missing.
+// Consumers have to resync from a snapshot taken at a later step.
+constexpr uint32_t DELTA_FRAME_OVERFLOWED = 1u << 0;
+
+// The grid was replaced (e.g. by restoring a snapshot) before this step, so earlier frames do not lead up to it.
+constexpr uint32_t DELTA_FRAME_DISCONTINUOUS = 1u << 1;
+
+struct WildfireDeltaStreamHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+};
+
+struct WildfireDeltaFrameHeader
+{
+    // The step which produced the changes (the grid after it is at step + 1).
+    uint32_t step;
+    uint32_t flags;
+    uint32_t changeCount;
+    uint32_t droppedCount;
+};
+
+static_assert(sizeof(WildfireDeltaStreamHeader) == 16, "The delta stream header layout must not change");
+static_assert(sizeof(WildfireDeltaFrameHeader) == 16, "The delta frame header layout must not change");
+
+constexpr uint32_t WILDFIRE_DELTA_STREAM_MAGIC = 0x544C4457; // "WDLT"
+constexpr uint32_t WILDFIRE_DELTA_STREAM_VERSION = 1;
+
+class WildfireDeltaStreamWriter
+{
+public:
+    bool open(const char* path, int width, int height);
+    void close();
+    bool isOpen() const { return file.is_open(); }
+
+    // Write one step's changes, in any order (e.g. straight out of a mapped GPU buffer). Each
+    // frame is flushed, so a consumer on a pipe sees it as soon as the step is done.
+    void writeFrame(uint32_t step, uint32_t flags, const WildfireCellChange* changes, size_t changeCount, size_t droppedCount = 0);
+
+private:
+    std::ofstream file;
+    std::vector<WildfireCellChange> sortedChanges;
+};
+
+class WildfireDeltaStreamReader
+{
+public:
+    bool open(const char* path);
+
+    int getWidth() const { return header.width; }
+    int getHeight() const { return header.height; }
+
+    // Read the next frame. Returns false at the end of the stream.
+    bool readFrame(WildfireDeltaFrameHeader& outFrame, std::vector<WildfireCellChange>& outChanges);
+
+private:
+    std::ifstream file;
+    WildfireDeltaStreamHeader header = {};
+};
+
+// Apply one frame's changes to a row major grid.
+void applyWildfireCellChanges(std::vector<WildfireCell>& cells, const std::vector<WildfireCellChange>& changes);
+
+#endif
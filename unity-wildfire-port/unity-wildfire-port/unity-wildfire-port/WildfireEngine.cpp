@@ -0,0 +1,567 @@
+#include "WildfireEngine.h"
+#include "WildfireTrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// Number of active front candidates evaluated per parallel job.
+static constexpr size_t CANDIDATE_CHUNK_SIZE = 4096;
+
+WildfireEngine::WildfireEngine(const WildfireLandscape& landscape, unsigned int threadCount)
+    : width(landscape.width),
+      height(landscape.height),
+      tileCountX((landscape.width + TILE_SIZE - 1) / TILE_SIZE),
+      tileCountY((landscape.height + TILE_SIZE - 1) / TILE_SIZE),
+      heights(landscape.heights),
+      slopeFactors(computeWildfireSlopeFactors(landscape)),
+      threadPool(threadCount)
+{
+    const size_t pixelCount = (size_t)width * height;
+
+    // Build the same texels generateWildfireTexture uploads.
+    cells[0].resize(pixelCount);
+    for (size_t pixel_index = 0; pixel_index < pixelCount; pixel_index++) {
+        cells[0][pixel_index] = WildfireCell{ landscape.materials[pixel_index], STATE_NOT_ON_FIRE };
+    }
+
+    cells[1] = cells[0];
+
+    // Drawn on the first step, once the parameters are known.
+    timers.assign(pixelCount, WILDFIRE_TIMER_NEVER);
+}
+
+WildfireStats WildfireEngine::computeStats()
+{
+    return computeWildfireStats(cells[currentBuffer].data(), width, height, (uint32_t)stepCount, burnedArea, threadPool);
+}
+
+void WildfireEngine::step(bool bIsMouseDown, glm::vec2 mousePos)
+{
+    WILDFIRE_TRACE_ZONE("WildfireEngine::step");
+
+    WildfireStepContext context;
+    context.step = (uint32_t)stepCount;
+    context.bIsMouseDown = bIsMouseDown;
+    context.mousePos = mousePos;
+    context.gridSize = glm::ivec2(width, height);
+    context.temperature = CalculateTemperature(parameters, context.step);
+
+    ruleTableCache.update(parameters);
+    context.ruleTable = &ruleTableCache.get();
+
+    if (parameters.bUseSlope) {
+        context.slopeFactors = slopeFactors.data();
+    }
+
+    if (windField != nullptr && windField->isOpen()) {
+        windField->update(context.step);
+        context.windField = windField;
+    }
+
+    updateTimers(context.step);
+    context.timers = timers.data();
+
+    if (steppingMode == WildfireSteppingMode::ActiveFront) {
+        stepActiveFront(context);
+    }
+    else {
+        stepDense(context);
+    }
+
+    ++stepCount;
+}
+
+void WildfireEngine::stepDense(const WildfireStepContext& context)
+{
+    const size_t tileCount = (size_t)tileCountX * tileCountY;
+    tileChanges.resize(bRecordChanges ? tileCount : 0);
+    tileIgnitedCounts.assign(tileCount * MATERIAL_COUNT, 0);
+
+    dispatchWildfireRules(getWildfireRules(parameters, context), [&](auto rules) {
+        threadPool.parallelFor(tileCount, [&](size_t tileIndex) {
+            stepTile<decltype(rules)::value>(context, (int)(tileIndex % tileCountX), (int)(tileIndex / tileCountX));
+        });
+    });
+
+    lastStepChanges.clear();
+    for (const std::vector<WildfireCellChange>& changes : tileChanges) {
+        lastStepChanges.insert(lastStepChanges.end(), changes.begin(), changes.end());
+    }
+
+    for (size_t tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        burnedArea.add(&tileIgnitedCounts[tileIndex * MATERIAL_COUNT]);
+    }
+
+    currentBuffer = 1 - currentBuffer;
+    lastStepEvaluatedCellCount = (size_t)width * height;
+
+    // The burning cell list is not maintained by dense steps.
+    bIsFrontDirty = true;
+}
+
+void WildfireEngine::step()
+{
+    const bool bIsMouseDown = bIsIgnitionPending;
+    bIsIgnitionPending = false;
+
+    step(bIsMouseDown, pendingIgnitionPos);
+}
+
+void WildfireEngine::ignite(glm::vec2 normalizedPos)
+{
+    bIsIgnitionPending = true;
+    pendingIgnitionPos = glm::clamp(normalizedPos, glm::vec2(0.0f), glm::vec2(1.0f));
+}
+
+void WildfireEngine::setCells(const std::vector<WildfireCell>& newCells)
+{
+    if (newCells.size() != cells[currentBuffer].size()) {
+        return;
+    }
+
+    cells[currentBuffer] = newCells;
+    burnedArea.reset(newCells.data(), newCells.size());
+    bAreTimersStale = true;
+    bIsFrontDirty = true;
+}
+
+void WildfireEngine::setTimers(const std::vector<uint32_t>& newTimers)
+{
+    if (newTimers.size() != timers.size()) {
+        return;
+    }
+
+    timers = newTimers;
+    timerGrassRegrowProbability = parameters.grassRegrowProbability;
+    timerTreeRegrowProbability = parameters.treeRegrowProbability;
+    bAreTimersStale = false;
+    bIsFrontDirty = true;
+}
+
+void WildfireEngine::updateTimers(uint32_t step)
+{
+    // The waiting times are memoryless, so timers drawn with other probabilities are simply redrawn.
+    if (bAreTimersStale
+        || parameters.grassRegrowProbability != timerGrassRegrowProbability
+        || parameters.treeRegrowProbability != timerTreeRegrowProbability) {
+        resampleTimers(step);
+    }
+}
+
+void WildfireEngine::resampleTimers(uint32_t step)
+{
+    const std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+
+    threadPool.parallelFor((size_t)height, [&](size_t y) {
+        for (size_t index = y * width; index < (y + 1) * width; index++) {
+            timers[index] = ResampleTimer(parameters, step, (uint32_t)index, currentCells[index]);
+        }
+    });
+
+    timerGrassRegrowProbability = parameters.grassRegrowProbability;
+    timerTreeRegrowProbability = parameters.treeRegrowProbability;
+    bAreTimersStale = false;
+    bIsFrontDirty = true;
+}
+
+template <uint32_t Rules>
+void WildfireEngine::stepTile(const WildfireStepContext& context, int tileX, int tileY)
+{
+    const std::vector<WildfireCell>& readCells = cells[currentBuffer];
+    std::vector<WildfireCell>& writeCells = cells[1 - currentBuffer];
+
+    // Out of bounds neighbours read as not on fire, just like imageLoad outside the image.
+    auto getNeighborState = [&](int x, int y) {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return (int)STATE_NOT_ON_FIRE;
+        }
+        return GetState(readCells[(size_t)y * width + x]);
+    };
+
+    const int startX = tileX * TILE_SIZE;
+    const int startY = tileY * TILE_SIZE;
+    const int endX = std::min(startX + TILE_SIZE, width);
+    const int endY = std::min(startY + TILE_SIZE, height);
+
+    const size_t tileIndex = (size_t)tileY * tileCountX + tileX;
+    std::vector<WildfireCellChange>* changes = bRecordChanges ? &tileChanges[tileIndex] : nullptr;
+    if (changes != nullptr) {
+        changes->clear();
+    }
+
+    uint32_t* ignitedCounts = &tileIgnitedCounts[tileIndex * MATERIAL_COUNT];
+
+    for (int y = startY; y < endY; y++) {
+        for (int x = startX; x < endX; x++) {
+            const size_t index = (size_t)y * width + x;
+
+            WildfireCell cellData = readCells[index];
+            processCell<Rules>(parameters, context, glm::ivec2(x, y), cellData, getNeighborState);
+            writeCells[index] = cellData;
+
+            if (cellData.state == STATE_ON_FIRE && readCells[index].state != STATE_ON_FIRE) {
+                ignitedCounts[std::min<int>(cellData.material, MATERIAL_COUNT - 1)]++;
+            }
+
+            if (changes != nullptr && (cellData.material != readCells[index].material || cellData.state != readCells[index].state)) {
+                changes->push_back(WildfireCellChange{ (uint32_t)index, cellData });
+            }
+        }
+    }
+}
+
+void WildfireEngine::rebuildBurningCells()
+{
+    const std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+
+    burningCells.clear();
+    pendingTimers.clear();
+    for (size_t index = 0; index < currentCells.size(); index++) {
+        if (GetState(currentCells[index]) == STATE_ON_FIRE) {
+            burningCells.push_back((uint32_t)index);
+        }
+        if (timers[index] != WILDFIRE_TIMER_NEVER) {
+            pendingTimers.emplace_back(timers[index], (uint32_t)index);
+        }
+    }
+    std::make_heap(pendingTimers.begin(), pendingTimers.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+
+    candidateStamps.assign(currentCells.size(), 0);
+    currentStamp = 0;
+    bIsFrontDirty = false;
+}
+
+void WildfireEngine::pushTimer(uint32_t index)
+{
+    if (timers[index] != WILDFIRE_TIMER_NEVER) {
+        pendingTimers.emplace_back(timers[index], index);
+        std::push_heap(pendingTimers.begin(), pendingTimers.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+    }
+}
+
+void WildfireEngine::addCandidate(uint32_t index)
+{
+    if (candidateStamps[index] != currentStamp) {
+        candidateStamps[index] = currentStamp;
+        candidateCells.push_back(index);
+    }
+}
+
+void WildfireEngine::stepActiveFront(const WildfireStepContext& context)
+{
+    if (bIsFrontDirty) {
+        rebuildBurningCells();
+    }
+
+    std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+
+    // Stamps tell which cells are candidates this step without clearing a per-cell array.
+    if (++currentStamp == 0) {
+        std::fill(candidateStamps.begin(), candidateStamps.end(), 0);
+        currentStamp = 1;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// GATHER THE ACTIVE FRONT
+    ////////////////////////////////////////////////////////////////////
+
+    // The unburnt neighbours of burning cells are the only cells whose neighbour rule can fire.
+    // Burning cells themselves wait for their burnout timer.
+    candidateCells.clear();
+    for (uint32_t index : burningCells) {
+        const int x = (int)(index % width);
+        const int y = (int)(index / width);
+
+        for (int j = -1; j <= 1; j++) {
+            for (int i = -1; i <= 1; i++) {
+                const int neighborX = x + i;
+                const int neighborY = y + j;
+                if (neighborX < 0 || neighborY < 0 || neighborX >= width || neighborY >= height) {
+                    continue;
+                }
+
+                const uint32_t neighborIndex = (uint32_t)neighborY * width + neighborX;
+                if (GetState(currentCells[neighborIndex]) == STATE_NOT_ON_FIRE) {
+                    addCandidate(neighborIndex);
+                }
+            }
+        }
+    }
+
+    // Burnout and regrowth which are due this step.
+    while (!pendingTimers.empty() && pendingTimers.front().first <= context.step) {
+        const std::pair<uint32_t, uint32_t> timer = pendingTimers.front();
+        std::pop_heap(pendingTimers.begin(), pendingTimers.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+        pendingTimers.pop_back();
+
+        if (timers[timer.second] == timer.first) {
+            addCandidate(timer.second);
+        }
+    }
+
+    // Cells under the mouse can catch fire without a burning neighbour.
+    if (context.bIsMouseDown) {
+        const glm::vec2 fireCenter = glm::vec2(context.gridSize) * context.mousePos;
+        const int minX = std::max(0, (int)std::floor(fireCenter.x - 10.0f));
+        const int maxX = std::min(width - 1, (int)std::ceil(fireCenter.x + 10.0f));
+        const int minY = std::max(0, (int)std::floor(fireCenter.y - 10.0f));
+        const int maxY = std::min(height - 1, (int)std::ceil(fireCenter.y + 10.0f));
+
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                if (IsImpactedByMouse(context, glm::vec2(x, y))) {
+                    addCandidate((uint32_t)y * width + x);
+                }
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// EVALUATE THE FRONT AGAINST THE CURRENT GRID
+    ////////////////////////////////////////////////////////////////////
+
+    auto getNeighborState = [&](int x, int y) {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return (int)STATE_NOT_ON_FIRE;
+        }
+        return GetState(currentCells[(size_t)y * width + x]);
+    };
+
+    const size_t chunkCount = (candidateCells.size() + CANDIDATE_CHUNK_SIZE - 1) / CANDIDATE_CHUNK_SIZE;
+    std::vector<std::vector<WildfireCellChange>> chunkChanges(chunkCount + 1);
+
+    dispatchWildfireRules(getWildfireRules(parameters, context), [&](auto rules) {
+        threadPool.parallelFor(chunkCount, [&](size_t chunkIndex) {
+            const size_t begin = chunkIndex * CANDIDATE_CHUNK_SIZE;
+            const size_t end = std::min(begin + CANDIDATE_CHUNK_SIZE, candidateCells.size());
+
+            for (size_t i = begin; i < end; i++) {
+                const uint32_t index = candidateCells[i];
+                const glm::ivec2 coord = glm::ivec2(index % width, index / width);
+
+                WildfireCell cellData = currentCells[index];
+                processCell<decltype(rules)::value>(parameters, context, coord, cellData, getNeighborState);
+
+                if (cellData.material != currentCells[index].material || cellData.state != currentCells[index].state) {
+                    chunkChanges[chunkIndex].push_back(WildfireCellChange{ index, cellData });
+                }
+            }
+        });
+    });
+
+    // Everything away from the front.
+    const size_t idleEventCount = sampleIdleEvents(context, chunkChanges[chunkCount]);
+
+    ////////////////////////////////////////////////////////////////////
+    /// APPLY THE CHANGES AND REBUILD THE FRONT
+    ////////////////////////////////////////////////////////////////////
+
+    for (const std::vector<WildfireCellChange>& changes : chunkChanges) {
+        for (const WildfireCellChange& change : changes) {
+            currentCells[change.index] = change.cell;
+            pushTimer(change.index);
+        }
+    }
+
+    // Burning cells only change when they burn out, so a change to ON_FIRE is a newly burning cell.
+    std::vector<uint32_t> nextBurningCells;
+    nextBurningCells.reserve(burningCells.size());
+
+    for (uint32_t index : burningCells) {
+        if (GetState(currentCells[index]) == STATE_ON_FIRE) {
+            nextBurningCells.push_back(index);
+        }
+    }
+    for (const std::vector<WildfireCellChange>& changes : chunkChanges) {
+        for (const WildfireCellChange& change : changes) {
+            if (GetState(change.cell) == STATE_ON_FIRE) {
+                nextBurningCells.push_back(change.index);
+                burnedArea.addIgnition(change.cell.material);
+            }
+        }
+    }
+
+    burningCells.swap(nextBurningCells);
+    lastStepEvaluatedCellCount = candidateCells.size() + idleEventCount;
+
+    lastStepChanges.clear();
+    if (bRecordChanges) {
+        for (const std::vector<WildfireCellChange>& changes : chunkChanges) {
+            lastStepChanges.insert(lastStepChanges.end(), changes.begin(), changes.end());
+        }
+    }
+}
+
+size_t WildfireEngine::sampleIdleEvents(const WildfireStepContext& context, std::vector<WildfireCellChange>& outChanges)
+{
+    // Away from the front and its due timers a cell only changes when its fire-catch draw falls
+    // below a small probability. Instead of drawing for every cell, jump between the cells which hit the
+    // bound of that probability (geometric skips), then thin the hits down to each cell's own
+    // probability. Each idle cell ends up with the per-step outcome distribution of the dense rule.
+    // The draws come from their own Philox stream, so sparse runs are deterministic too, but they
+    // do not reproduce the dense run draw for draw.
+    const float probabilityBound = GetIdleEventProbabilityBound(parameters);
+    if (probabilityBound <= 0.0f) {
+        return 0;
+    }
+
+    const std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+    const uint64_t cellCount = currentCells.size();
+
+    const double logMiss = std::log1p(-(double)probabilityBound);
+
+    size_t sampledCount = 0;
+    uint64_t index = 0;
+    while (true) {
+        if (probabilityBound < 1.0f) {
+            // 1 - u is in (0, 1], so the logarithm is finite.
+            const double u = 1.0 - wildfireRandom(parameters.seed, context.step, (uint32_t)index, 0, RANDOM_STREAM_IDLE_EVENTS);
+            index += (uint64_t)std::floor(std::log(u) / logMiss);
+        }
+        if (index >= cellCount) {
+            break;
+        }
+
+        // Front cells were evaluated with the full rule already.
+        const WildfireCell& currentCell = currentCells[index];
+        if (candidateStamps[index] != currentStamp && GetState(currentCell) != STATE_ON_FIRE) {
+            const PhiloxBlock randomBlock = wildfireRandomBlock(parameters.seed, context.step, (uint32_t)index, 1, RANDOM_STREAM_IDLE_EVENTS);
+            const float eventRandom = wildfireRandomFromBlock(randomBlock, 0) * probabilityBound;
+
+            if (eventRandom < GetIdleEventProbability(parameters, currentCell)) {
+                WildfireCell cellData = currentCell;
+                processIdleEvent(parameters, context, (uint32_t)index, cellData, wildfireRandomFromBlock(randomBlock, 1));
+
+                if (cellData.material != currentCell.material || cellData.state != currentCell.state) {
+                    outChanges.push_back(WildfireCellChange{ (uint32_t)index, cellData });
+                }
+            }
+        }
+
+        ++sampledCount;
+        ++index;
+    }
+
+    return sampledCount;
+}
+
+////////////////////////////////////////////////////////////////////
+/// QUIET STEPS
+////////////////////////////////////////////////////////////////////
+
+int WildfireEngine::skipQuietSteps(int maxStepCount)
+{
+    if (bIsIgnitionPending || maxStepCount <= 0) {
+        return 0;
+    }
+
+    const uint32_t startStep = (uint32_t)stepCount;
+    updateTimers(startStep);
+    if (bIsFrontDirty) {
+        rebuildBurningCells();
+    }
+    if (!burningCells.empty()) {
+        return 0;
+    }
+
+    ruleTableCache.update(parameters);
+
+    std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+    const uint64_t cellCount = currentCells.size();
+    std::vector<uint32_t> changedCells;
+
+    // Every (step, cell) pair of the quiet period draws the fire-catch roll of processCell. Walk
+    // the pairs step-major with geometric skips between the rolls which hit, exactly like
+    // sampleIdleEvents walks the cells of one step, and thin each hit by the flammability of the
+    // cell as it is on that step. The first step with an ignition ends the jump.
+    const float probability = glm::clamp(parameters.fireProbability, 0.0f, 1.0f);
+    const double logMiss = std::log1p(-(double)probability);
+    const double endPosition = (double)maxStepCount * (double)cellCount;
+
+    uint32_t endStep = startStep + (uint32_t)maxStepCount;
+    uint32_t hitIndex = 0;
+    double position = 0.0;
+    while (probability > 0.0f) {
+        const PhiloxBlock randomBlock = wildfireRandomBlock(parameters.seed, startStep, hitIndex++, 0, RANDOM_STREAM_QUIET_STEPS);
+        if (probability < 1.0f) {
+            // 1 - u is in (0, 1], so the logarithm is finite.
+            position += std::floor(std::log(1.0 - wildfireRandomFromBlock(randomBlock, 0)) / logMiss);
+        }
+        if (position >= endPosition) {
+            break;
+        }
+
+        const uint64_t flatIndex = (uint64_t)position;
+        const uint32_t hitStep = startStep + (uint32_t)(flatIndex / cellCount);
+        const uint32_t index = (uint32_t)(flatIndex % cellCount);
+        if (hitStep >= endStep) {
+            break;
+        }
+
+        // Bring the grid to the start of the hit's step.
+        applyDueTimers(hitStep, changedCells);
+
+        // A grass cell whose regrowth is due this step regrows instead of rolling for fire.
+        WildfireCell& cellData = currentCells[index];
+        if (GetState(cellData) == STATE_NOT_ON_FIRE && timers[index] > hitStep) {
+            WildfireStepContext context;
+            context.step = hitStep;
+            context.gridSize = glm::ivec2(width, height);
+            context.temperature = CalculateTemperature(parameters, hitStep);
+            context.ruleTable = &ruleTableCache.get();
+            context.timers = timers.data();
+
+            processIdleEvent(parameters, context, index, cellData, wildfireRandomFromBlock(randomBlock, 1));
+            if (GetState(cellData) == STATE_ON_FIRE) {
+                burningCells.push_back(index);
+                pushTimer(index);
+                changedCells.push_back(index);
+                burnedArea.addIgnition(cellData.material);
+
+                // The rest of this step's pairs may ignite too, then the fire runs at full rate.
+                endStep = hitStep + 1;
+            }
+        }
+
+        position += 1.0;
+    }
+
+    applyDueTimers(endStep, changedCells);
+    stepCount = (int)endStep;
+
+    lastStepChanges.clear();
+    if (bRecordChanges) {
+        if (++currentStamp == 0) {
+            std::fill(candidateStamps.begin(), candidateStamps.end(), 0);
+            currentStamp = 1;
+        }
+        for (uint32_t index : changedCells) {
+            if (candidateStamps[index] != currentStamp) {
+                candidateStamps[index] = currentStamp;
+                lastStepChanges.push_back(WildfireCellChange{ index, currentCells[index] });
+            }
+        }
+    }
+    lastStepEvaluatedCellCount = changedCells.size();
+
+    return (int)(endStep - startStep);
+}
+
+void WildfireEngine::applyDueTimers(uint32_t endStep, std::vector<uint32_t>& outChangedCells)
+{
+    std::vector<WildfireCell>& currentCells = cells[currentBuffer];
+
+    // Transitions which fire inside the window push their next timer, which may fire inside it too.
+    while (!pendingTimers.empty() && pendingTimers.front().first < endStep) {
+        const std::pair<uint32_t, uint32_t> timer = pendingTimers.front();
+        std::pop_heap(pendingTimers.begin(), pendingTimers.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+        pendingTimers.pop_back();
+
+        if (timers[timer.second] == timer.first
+            && ApplyDueTimer(parameters, timer.first, timer.second, currentCells[timer.second], timers[timer.second])) {
+            pushTimer(timer.second);
+            outChangedCells.push_back(timer.second);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#ifndef WILDFIRE_ENGINE_H
+#define WILDFIRE_ENGINE_H
+
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+#include "WildfireStats.h"
+#include "WildfireThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class WildfireSteppingMode
+{
+    // Evaluate every cell of the grid each step, exactly like the compute shader.
+    Dense,
+
+    // Only evaluate the unburnt cells next to the fire and the cells whose timer is due (see
+    // SampleTimerDelay). Spontaneous ignition elsewhere is sampled as sparse events, so a step
+    // costs O(fire front), not O(grid).
+    ActiveFront,
+};
+
+// Headless CPU implementation of Shaders/wildfireCompute.cs. The grid is stepped in tiles
+// across every core and needs no OpenGL context, so scenarios can run on batch nodes.
+class WildfireEngine
+{
+public:
+    // Edge length of the square tiles handed to the worker threads.
+    static constexpr int TILE_SIZE = 64;
+
+    // threadCount == 0 uses every hardware thread.
+    explicit WildfireEngine(const WildfireLandscape& landscape, unsigned int threadCount = 0);
+
+    // Advance the grid by one step with the same inputs the render loop gives the compute shader.
+    // The step counter and parameters.seed key the random numbers, so the result does not
+    // depend on the thread count.
+    void step(bool bIsMouseDown, glm::vec2 mousePos);
+
+    // Advance the grid by one step, consuming a pending ignite().
+    void step();
+
+    // Start a fire around a normalized (0-1) grid position on the next step(), like a mouse click.
+    void ignite(glm::vec2 normalizedPos);
+
+    // Long-horizon stepping. While nothing burns, the grid only changes through the timers and
+    // spontaneous ignition, and neither looks at the neighbours. Jump straight to the step of
+    // the next sampled ignition (at most maxStepCount steps), applying the timers due on the
+    // way in bulk, and step() again from there while the fire runs. Returns the number of steps
+    // advanced: 0 while a fire is burning or an ignition is pending.
+    int skipQuietSteps(int maxStepCount);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStepCount() const { return stepCount; }
+
+    // Resume the random numbers of a restored run (see WildfireSnapshot).
+    void setStepCount(int newStepCount) { stepCount = newStepCount; }
+    unsigned int getThreadCount() const { return threadPool.getThreadCount(); }
+
+    // The current grid in the same GL_RG8UI layout as wildfireTextures.
+    const std::vector<WildfireCell>& getCells() const { return cells[currentBuffer]; }
+
+    // Replacing the cells redraws every timer on the next step, unless setTimers() follows.
+    // The burned area starts over from the new cells.
+    void setCells(const std::vector<WildfireCell>& newCells);
+
+    // The step each cell's burnout or regrowth fires at (WILDFIRE_TIMER_NEVER for none).
+    const std::vector<uint32_t>& getTimers() const { return timers; }
+
+    // False until the first step() after the cells were replaced, which draws the timers.
+    bool hasTimers() const { return !bAreTimersStale; }
+
+    // Restore timers saved with the cells. They are taken as drawn with the current parameters.
+    void setTimers(const std::vector<uint32_t>& newTimers);
+
+    // The static height plane (normalized to 0-65535).
+    const std::vector<uint16_t>& getHeights() const { return heights; }
+
+    // Number of cells evaluated by the last step.
+    size_t getLastStepEvaluatedCellCount() const { return lastStepEvaluatedCellCount; }
+
+    // The cells the last step (or skipQuietSteps) changed, in no particular order. Only filled
+    // while bRecordChanges is set.
+    const std::vector<WildfireCellChange>& getLastStepChanges() const { return lastStepChanges; }
+
+    // Stats of the current grid, reduced across the worker threads.
+    WildfireStats computeStats();
+
+    // The cells set on fire so far, counted by every step.
+    const WildfireBurnedArea& getBurnedArea() const { return burnedArea; }
+
+    WildfireParameters parameters;
+
+    WildfireSteppingMode steppingMode = WildfireSteppingMode::Dense;
+
+    // Collect the changed cells of every step (see WildfireDeltaStream.h).
+    bool bRecordChanges = false;
+
+    // Spatially varying wind which replaces parameters' wind while set. Not owned; the engine
+    // advances it to each step.
+    WildfireWindField* windField = nullptr;
+
+private:
+    void stepDense(const WildfireStepContext& context);
+    template <uint32_t Rules>
+    void stepTile(const WildfireStepContext& context, int tileX, int tileY);
+
+    void updateTimers(uint32_t step);
+    void resampleTimers(uint32_t step);
+    // Pop and apply every timer due before endStep, adding the changed cells to outChangedCells.
+    void applyDueTimers(uint32_t endStep, std::vector<uint32_t>& outChangedCells);
+
+    void stepActiveFront(const WildfireStepContext& context);
+    void rebuildBurningCells();
+    void pushTimer(uint32_t index);
+    void addCandidate(uint32_t index);
+    // Returns the number of cells visited.
+    size_t sampleIdleEvents(const WildfireStepContext& context, std::vector<WildfireCellChange>& outChanges);
+
+    int width;
+    int height;
+    int tileCountX;
+    int tileCountY;
+
+    // Read from cells[currentBuffer], write to the other buffer, then swap.
+    std::vector<WildfireCell> cells[2];
+    int currentBuffer = 0;
+
+    std::vector<uint16_t> heights;
+    std::vector<uint32_t> slopeFactors;
+
+    // One plane for both buffers: a cell only reads and writes its own timer.
+    std::vector<uint32_t> timers;
+
+    // Set when the timers do not match the cells, e.g. after setCells(). The regrowth
+    // probabilities the timers were drawn with, to redraw them when the parameters change.
+    bool bAreTimersStale = true;
+    float timerGrassRegrowProbability = 0.0f;
+    float timerTreeRegrowProbability = 0.0f;
+
+    int stepCount = 0;
+
+    size_t lastStepEvaluatedCellCount = 0;
+
+    // Dense steps collect the changes per tile, so the workers never share a list.
+    std::vector<std::vector<WildfireCellChange>> tileChanges;
+    std::vector<WildfireCellChange> lastStepChanges;
+
+    // Dense steps count the cells they set on fire per tile too, MATERIAL_COUNT per tile.
+    std::vector<uint32_t> tileIgnitedCounts;
+    WildfireBurnedArea burnedArea;
+
+    // Active front state. burningCells and pendingTimers are rebuilt from the grid whenever
+    // bIsFrontDirty is set.
+    std::vector<uint32_t> burningCells;
+
+    // Min-heap of (timer, cell). An entry is stale once the cell's timer no longer matches.
+    std::vector<std::pair<uint32_t, uint32_t>> pendingTimers;
+
+    std::vector<uint32_t> candidateCells;
+    std::vector<uint32_t> candidateStamps;
+    uint32_t currentStamp = 0;
+    bool bIsFrontDirty = true;
+
+    bool bIsIgnitionPending = false;
+    glm::vec2 pendingIgnitionPos = glm::vec2(0.0f, 0.0f);
+
+    // Rebuilt whenever the wind or a flammable probability changes.
+    WildfireRuleTableCache ruleTableCache;
+
+    WildfireThreadPool threadPool;
+};
+
+#endif
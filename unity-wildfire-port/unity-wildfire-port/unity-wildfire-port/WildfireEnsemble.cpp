@@ -0,0 +1,177 @@
+#include "WildfireEnsemble.h"
+
+#include <algorithm>
+#include <cstring>
+
+WildfireEnsemble::WildfireEnsemble(const WildfireLandscape& landscape, int memberCount, unsigned int threadCount)
+    : width(landscape.width),
+      height(landscape.height),
+      memberCount(std::max(memberCount, 1)),
+      tileCountX((landscape.width + TILE_SIZE - 1) / TILE_SIZE),
+      tileCountY((landscape.height + TILE_SIZE - 1) / TILE_SIZE),
+      materials(landscape.materials),
+      heights(landscape.heights),
+      slopeFactors(computeWildfireSlopeFactors(landscape)),
+      threadPool(threadCount)
+{
+    const size_t pixelCount = (size_t)width * height;
+
+    states[0].assign(pixelCount * this->memberCount, STATE_NOT_ON_FIRE);
+    states[1] = states[0];
+
+    tileHasFire.assign((size_t)tileCountX * tileCountY, 0);
+}
+
+void WildfireEnsemble::step()
+{
+    const bool bIsMouseDown = bIsIgnitionPending;
+    bIsIgnitionPending = false;
+
+    // One set of parameters per member. Only the seed (and with it the temperature noise) differs.
+    std::vector<WildfireParameters> memberParameters(memberCount, parameters);
+
+    for (int member = 0; member < memberCount; member++) {
+        memberParameters[member].seed = parameters.seed + (uint64_t)member;
+        memberParameters[member].treeRegrowProbability = 0.0f;
+        memberParameters[member].grassRegrowProbability = 0.0f;
+    }
+
+    WildfireStepContext context;
+    context.step = (uint32_t)stepCount;
+    context.bIsMouseDown = bIsMouseDown;
+    context.mousePos = pendingIgnitionPos;
+    context.gridSize = glm::ivec2(width, height);
+
+    // The members only differ in their seed, so they share one rule table.
+    ruleTableCache.update(parameters);
+    context.ruleTable = &ruleTableCache.get();
+
+    if (parameters.bUseSlope) {
+        context.slopeFactors = slopeFactors.data();
+    }
+
+    // Without spontaneous ignition, only tiles near a fire or under the click can change.
+    const bool bCanSkipTiles = parameters.fireProbability <= 0.0f;
+
+    std::vector<uint8_t> nextTileHasFire(tileHasFire.size(), 0);
+    std::vector<uint8_t> tileWasStepped(tileHasFire.size(), 0);
+
+    // Every member shares the rules: the seeds differ, the switches do not.
+    dispatchWildfireRules<WILDFIRE_RULE_ALL & ~WILDFIRE_RULE_TIMERS>(getWildfireRules(memberParameters[0], context), [&](auto rules) {
+        threadPool.parallelFor((size_t)tileCountX * tileCountY, [&](size_t tileIndex) {
+            const int tileX = (int)(tileIndex % tileCountX);
+            const int tileY = (int)(tileIndex / tileCountX);
+
+            const int startX = tileX * TILE_SIZE;
+            const int startY = tileY * TILE_SIZE;
+            const int endX = std::min(startX + TILE_SIZE, width);
+            const int endY = std::min(startY + TILE_SIZE, height);
+
+            if (bCanSkipTiles && !isTileActive(context, tileX, tileY)) {
+                // Nothing changes, but the write buffer still needs the current states.
+                const size_t rowBytes = (size_t)(endX - startX) * memberCount;
+                for (int y = startY; y < endY; y++) {
+                    const size_t offset = ((size_t)y * width + startX) * memberCount;
+                    std::memcpy(&states[1 - currentBuffer][offset], &states[currentBuffer][offset], rowBytes);
+                }
+                return;
+            }
+
+            // The temperature only depends on the member's seed and the step.
+            std::vector<WildfireStepContext> memberContexts(memberCount, context);
+            for (int member = 0; member < memberCount; member++) {
+                memberContexts[member].temperature = CalculateTemperature(memberParameters[member], context.step);
+            }
+
+            const std::vector<uint8_t>& readStates = states[currentBuffer];
+            std::vector<uint8_t>& writeStates = states[1 - currentBuffer];
+
+            bool bHasFire = false;
+
+            for (int y = startY; y < endY; y++) {
+                for (int x = startX; x < endX; x++) {
+                    const size_t cellIndex = (size_t)y * width + x;
+                    const size_t stateOffset = cellIndex * memberCount;
+
+                    for (int member = 0; member < memberCount; member++) {
+                        // Out of bounds neighbours read as not on fire, just like imageLoad outside the image.
+                        auto getNeighborState = [&](int neighborX, int neighborY) {
+                            if (neighborX < 0 || neighborY < 0 || neighborX >= width || neighborY >= height) {
+                                return (int)STATE_NOT_ON_FIRE;
+                            }
+                            return (int)readStates[((size_t)neighborY * width + neighborX) * memberCount + member];
+                        };
+
+                        WildfireCell cellData = WildfireCell{ materials[cellIndex], readStates[stateOffset + member] };
+                        processCell<decltype(rules)::value>(memberParameters[member], memberContexts[member], glm::ivec2(x, y), cellData, getNeighborState);
+                        writeStates[stateOffset + member] = cellData.state;
+
+                        bHasFire |= cellData.state == STATE_ON_FIRE;
+                    }
+                }
+            }
+
+            nextTileHasFire[tileIndex] = bHasFire;
+            tileWasStepped[tileIndex] = 1;
+        });
+    });
+
+    tileHasFire.swap(nextTileHasFire);
+    currentBuffer = 1 - currentBuffer;
+    lastStepActiveTileCount = (size_t)std::count(tileWasStepped.begin(), tileWasStepped.end(), 1);
+    ++stepCount;
+}
+
+bool WildfireEnsemble::isTileActive(const WildfireStepContext& context, int tileX, int tileY) const
+{
+    if (context.bIsMouseDown) {
+        // Distance from the click to the closest point of the tile.
+        const glm::vec2 fireCenter = glm::vec2(context.gridSize) * context.mousePos;
+        const glm::vec2 tileMin = glm::vec2(tileX, tileY) * (float)TILE_SIZE;
+        const glm::vec2 closestPoint = glm::clamp(fireCenter, tileMin, tileMin + glm::vec2((float)TILE_SIZE));
+        if (glm::length(fireCenter - closestPoint) < 10.0f) {
+            return true;
+        }
+    }
+
+
+    // Fire spreads one cell per step, so it can only enter a tile from a neighbouring tile.
+    for (int j = -1; j <= 1; j++) {
+        for (int i = -1; i <= 1; i++) {
+            const int neighborTileX = tileX + i;
+            const int neighborTileY = tileY + j;
+            if (neighborTileX < 0 || neighborTileY < 0 || neighborTileX >= tileCountX || neighborTileY >= tileCountY) {
+                continue;
+            }
+            if (tileHasFire[(size_t)neighborTileY * tileCountX + neighborTileX]) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void WildfireEnsemble::ignite(glm::vec2 normalizedPos)
+{
+    bIsIgnitionPending = true;
+    pendingIgnitionPos = glm::clamp(normalizedPos, glm::vec2(0.0f), glm::vec2(1.0f));
+}
+
+std::vector<float> WildfireEnsemble::getBurnProbability() const
+{
+    const std::vector<uint8_t>& currentStates = states[currentBuffer];
+    const size_t pixelCount = (size_t)width * height;
+
+    // Without regrowth a cell which caught fire stays burning or burnt, so the final states tell which members burned it.
+    std::vector<float> burnProbability(pixelCount);
+    for (size_t cellIndex = 0; cellIndex < pixelCount; cellIndex++) {
+        int burnedCount = 0;
+        for (int member = 0; member < memberCount; member++) {
+            burnedCount += currentStates[cellIndex * memberCount + member] != STATE_NOT_ON_FIRE;
+        }
+        burnProbability[cellIndex] = (float)burnedCount / memberCount;
+    }
+
+    return burnProbability;
+}
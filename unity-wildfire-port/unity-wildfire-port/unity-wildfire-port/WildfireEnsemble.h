@@ -0,0 +1,91 @@
+#ifndef WILDFIRE_ENSEMBLE_H
+#define WILDFIRE_ENSEMBLE_H
+
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+#include "WildfireThreadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Many Monte Carlo realizations of the same scenario stepped together. The static material and
+// height planes are stored once, and the state of every member is interleaved per cell
+// (states[cell * memberCount + member]), so one pass over memory advances the whole ensemble
+// and the inner loop over members walks contiguous bytes.
+//
+// Regrowth changes the material of a cell, which the members share, so it is disabled. The
+// ensemble answers "where does this ignition burn", not long-horizon landscape dynamics.
+// There is no timer plane per member either, so burnout is rolled every step.
+class WildfireEnsemble
+{
+public:
+    // Edge length of the square tiles handed to the worker threads.
+    static constexpr int TILE_SIZE = 64;
+
+    // threadCount == 0 uses every hardware thread.
+    WildfireEnsemble(const WildfireLandscape& landscape, int memberCount, unsigned int threadCount = 0);
+
+    // Advance every member by one step. Member m draws its random numbers with the seed
+    // parameters.seed + m.
+    void step();
+
+    // Start a fire around a normalized (0-1) grid position in every member on the next step().
+    void ignite(glm::vec2 normalizedPos);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getMemberCount() const { return memberCount; }
+    int getStepCount() const { return stepCount; }
+    unsigned int getThreadCount() const { return threadPool.getThreadCount(); }
+
+    // State of one member at a cell.
+    int getState(size_t cellIndex, int member) const { return states[currentBuffer][cellIndex * memberCount + member]; }
+
+    // The static planes shared by every member.
+    const std::vector<unsigned char>& getMaterials() const { return materials; }
+    const std::vector<uint16_t>& getHeights() const { return heights; }
+
+    // Fraction of members in which each cell is burning or burnt, row major like the grid.
+    std::vector<float> getBurnProbability() const;
+
+    // Number of tiles stepped by the last step (tiles without fire nearby are skipped).
+    size_t getLastStepActiveTileCount() const { return lastStepActiveTileCount; }
+
+    WildfireParameters parameters;
+
+private:
+    bool isTileActive(const WildfireStepContext& context, int tileX, int tileY) const;
+
+    int width;
+    int height;
+    int memberCount;
+    int tileCountX;
+    int tileCountY;
+
+    std::vector<unsigned char> materials;
+    std::vector<uint16_t> heights;
+    std::vector<uint32_t> slopeFactors;
+
+    // Read from states[currentBuffer], write to the other buffer, then swap.
+    std::vector<uint8_t> states[2];
+    int currentBuffer = 0;
+
+    // Whether any member had a burning cell in the tile after the last step. A tile whose
+    // neighbourhood has no fire cannot change without spontaneous ignition.
+    std::vector<uint8_t> tileHasFire;
+
+    int stepCount = 0;
+    size_t lastStepActiveTileCount = 0;
+
+    bool bIsIgnitionPending = false;
+    glm::vec2 pendingIgnitionPos = glm::vec2(0.0f, 0.0f);
+
+    // Rebuilt whenever the wind or a flammable probability changes.
+    WildfireRuleTableCache ruleTableCache;
+
+    WildfireThreadPool threadPool;
+};
+
+#endif
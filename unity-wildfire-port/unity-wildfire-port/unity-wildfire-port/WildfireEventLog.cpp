@@ -0,0 +1,189 @@
+#include "WildfireEventLog.h"
+
+#include <iostream>
+
+float getWildfireParameter(const WildfireParameters& parameters, WildfireParameterId parameter)
+{
+    switch (parameter)
+    {
+    case WildfireParameterId::FireProbability: return parameters.fireProbability;
+    case WildfireParameterId::FlammableProbabilityForGrass: return parameters.flammableProbabilityForGrass;
+    case WildfireParameterId::FlammableProbabilityForWater: return parameters.flammableProbabilityForWater;
+    case WildfireParameterId::FlammableProbabilityForBedrock: return parameters.flammableProbabilityForBedrock;
+    case WildfireParameterId::FlammableProbabilityForTree: return parameters.flammableProbabilityForTree;
+    case WildfireParameterId::GrassRegrowProbability: return parameters.grassRegrowProbability;
+    case WildfireParameterId::TreeRegrowProbability: return parameters.treeRegrowProbability;
+    case WildfireParameterId::UseTemperature: return parameters.bUseTemperature ? 1.0f : 0.0f;
+    case WildfireParameterId::UseWind: return parameters.bUseWind ? 1.0f : 0.0f;
+    case WildfireParameterId::UseSlope: return parameters.bUseSlope ? 1.0f : 0.0f;
+    case WildfireParameterId::UseVonNeumannNeighborhood: return parameters.bUseVonNeumannNeighborhood ? 1.0f : 0.0f;
+    default: return 0.0f;
+    }
+}
+
+void setWildfireParameter(WildfireParameters& parameters, WildfireParameterId parameter, float value)
+{
+    switch (parameter)
+    {
+    case WildfireParameterId::FireProbability: parameters.fireProbability = value; break;
+    case WildfireParameterId::FlammableProbabilityForGrass: parameters.flammableProbabilityForGrass = value; break;
+    case WildfireParameterId::FlammableProbabilityForWater: parameters.flammableProbabilityForWater = value; break;
+    case WildfireParameterId::FlammableProbabilityForBedrock: parameters.flammableProbabilityForBedrock = value; break;
+    case WildfireParameterId::FlammableProbabilityForTree: parameters.flammableProbabilityForTree = value; break;
+    case WildfireParameterId::GrassRegrowProbability: parameters.grassRegrowProbability = value; break;
+    case WildfireParameterId::TreeRegrowProbability: parameters.treeRegrowProbability = value; break;
+    case WildfireParameterId::UseTemperature: parameters.bUseTemperature = value != 0.0f; break;
+    case WildfireParameterId::UseWind: parameters.bUseWind = value != 0.0f; break;
+    case WildfireParameterId::UseSlope: parameters.bUseSlope = value != 0.0f; break;
+    case WildfireParameterId::UseVonNeumannNeighborhood: parameters.bUseVonNeumannNeighborhood = value != 0.0f; break;
+    default: break;
+    }
+}
+
+void applyWildfireEvent(WildfireParameters& parameters, const WildfireEvent& event)
+{
+    if (event.type == WildfireEventType::Parameter) {
+        setWildfireParameter(parameters, event.parameter, event.x);
+    }
+    else if (event.type == WildfireEventType::Wind) {
+        parameters.windDirectionIndex = (int)event.x;
+        parameters.windAngleDegrees = event.y;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+/// RECORDING
+////////////////////////////////////////////////////////////////////
+
+bool WildfireEventRecorder::open(const char* path, int width, int height, const WildfireParameters& parameters)
+{
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create event log: " << path << std::endl;
+        return false;
+    }
+
+    WildfireEventLogHeader header = {};
+    header.magic = WILDFIRE_EVENT_LOG_MAGIC;
+    header.version = WILDFIRE_EVENT_LOG_VERSION;
+    header.width = width;
+    header.height = height;
+    header.seed = parameters.seed;
+    file.write((const char*)&header, sizeof(header));
+
+    for (int parameter = 0; parameter < (int)WildfireParameterId::Count; parameter++) {
+        write(0, WildfireEventType::Parameter, (WildfireParameterId)parameter, getWildfireParameter(parameters, (WildfireParameterId)parameter), 0.0f);
+    }
+    write(0, WildfireEventType::Wind, WildfireParameterId::Count, (float)parameters.windDirectionIndex, parameters.windAngleDegrees);
+
+    recordedParameters = parameters;
+    return true;
+}
+
+void WildfireEventRecorder::close(uint32_t stepCount, float sessionSeconds)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    write(stepCount, WildfireEventType::End, WildfireParameterId::Count, sessionSeconds, 0.0f);
+    file.close();
+}
+
+void WildfireEventRecorder::recordIgnition(uint32_t step, glm::vec2 normalizedPos)
+{
+    write(step, WildfireEventType::Ignite, WildfireParameterId::Count, normalizedPos.x, normalizedPos.y);
+}
+
+void WildfireEventRecorder::recordParameters(uint32_t step, const WildfireParameters& parameters)
+{
+    for (int parameter = 0; parameter < (int)WildfireParameterId::Count; parameter++) {
+        const float value = getWildfireParameter(parameters, (WildfireParameterId)parameter);
+        if (value != getWildfireParameter(recordedParameters, (WildfireParameterId)parameter)) {
+            write(step, WildfireEventType::Parameter, (WildfireParameterId)parameter, value, 0.0f);
+        }
+    }
+
+    if (parameters.windDirectionIndex != recordedParameters.windDirectionIndex || parameters.windAngleDegrees != recordedParameters.windAngleDegrees) {
+        write(step, WildfireEventType::Wind, WildfireParameterId::Count, (float)parameters.windDirectionIndex, parameters.windAngleDegrees);
+    }
+
+    recordedParameters = parameters;
+}
+
+void WildfireEventRecorder::write(uint32_t step, WildfireEventType type, WildfireParameterId parameter, float x, float y)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    const WildfireEvent event = { step, type, parameter, 0, x, y };
+    file.write((const char*)&event, sizeof(event));
+}
+
+////////////////////////////////////////////////////////////////////
+/// LOADING
+////////////////////////////////////////////////////////////////////
+
+bool loadWildfireEventLog(const char* path, WildfireEventLog& outLog)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open event log: " << path << std::endl;
+        return false;
+    }
+
+    const size_t fileSize = (size_t)file.tellg();
+    file.seekg(0);
+
+    WildfireEventLogHeader header = {};
+    file.read((char*)&header, sizeof(header));
+
+    // A session which did not close the log may have been cut off mid-record.
+    const bool bIsHeaderValid = file && fileSize >= sizeof(header)
+        && header.magic == WILDFIRE_EVENT_LOG_MAGIC
+        && header.version >= WILDFIRE_EVENT_LOG_MIN_VERSION && header.version <= WILDFIRE_EVENT_LOG_VERSION
+        && header.width > 0 && header.height > 0;
+
+    if (!bIsHeaderValid) {
+        std::cerr << "Not a valid event log: " << path << std::endl;
+        return false;
+    }
+
+    outLog.width = header.width;
+    outLog.height = header.height;
+    outLog.seed = header.seed;
+    outLog.stepCount = 0;
+    outLog.sessionSeconds = 0.0f;
+    outLog.events.resize((fileSize - sizeof(header)) / sizeof(WildfireEvent));
+    file.read((char*)outLog.events.data(), (std::streamsize)(outLog.events.size() * sizeof(WildfireEvent)));
+
+    // Sessions recorded before these toggles existed ran without them. Logs which did record
+    // them set them again at step 0, after these.
+    if (header.version < 2) {
+        const WildfireEvent slopeOff = { 0, WildfireEventType::Parameter, WildfireParameterId::UseSlope, 0, 0.0f, 0.0f };
+        const WildfireEvent vonNeumannOff = { 0, WildfireEventType::Parameter, WildfireParameterId::UseVonNeumannNeighborhood, 0, 0.0f, 0.0f };
+        outLog.events.insert(outLog.events.begin(), { slopeOff, vonNeumannOff });
+    }
+
+    uint32_t previousStep = 0;
+    for (size_t eventIndex = 0; eventIndex < outLog.events.size(); eventIndex++) {
+        const WildfireEvent& event = outLog.events[eventIndex];
+        if (event.step < previousStep || event.type > WildfireEventType::End) {
+            std::cerr << "Corrupt event log: " << path << std::endl;
+            return false;
+        }
+        previousStep = event.step;
+
+        if (event.type == WildfireEventType::End) {
+            outLog.stepCount = event.step;
+            outLog.sessionSeconds = event.x;
+            outLog.events.resize(eventIndex);
+            return true;
+        }
+
+        outLog.stepCount = event.step + 1;
+    }
+
+    return true;
+}
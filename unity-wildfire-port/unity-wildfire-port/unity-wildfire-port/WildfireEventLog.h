@@ -0,0 +1,131 @@
+#ifndef WILDFIRE_EVENT_LOG_H
+#define WILDFIRE_EVENT_LOG_H
+
+#include "WildfireRules.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Binary log of everything an operator does to a run: ignitions, parameter changes and wind
+// changes, each tagged with the simulation step it applies to. Given the same landscape and
+// seed, the rules are deterministic, so replaying the log reproduces the session exactly.
+//
+// Layout (little endian):
+//   WildfireEventLogHeader
+//   WildfireEvent[]   (in step order, ending with an End event once the session closes)
+//
+// ----------------------------------------------------------------------------
+
+enum class WildfireEventType : uint8_t
+{
+    // Start a fire at the normalized grid position (x, y), like a mouse click.
+    Ignite = 0,
+
+    // Set the parameter in WildfireEvent::parameter to x.
+    Parameter = 1,
+
+    // Set the wind direction index to x and the wind angle to y (degrees).
+    Wind = 2,
+
+    // The session stopped before this step. x holds the session's wall time in seconds.
+    End = 3,
+};
+
+// The scalar WildfireParameters fields a Parameter event can set (booleans are 0 or 1).
+enum class WildfireParameterId : uint8_t
+{
+    FireProbability = 0,
+    FlammableProbabilityForGrass,
+    FlammableProbabilityForWater,
+    FlammableProbabilityForBedrock,
+    FlammableProbabilityForTree,
+    GrassRegrowProbability,
+    TreeRegrowProbability,
+    UseTemperature,
+    UseWind,
+    UseSlope,
+    UseVonNeumannNeighborhood,
+
+    Count
+};
+
+struct WildfireEvent
+{
+    uint32_t step;
+    WildfireEventType type;
+    WildfireParameterId parameter;
+    uint16_t padding;
+    float x;
+    float y;
+};
+
+struct WildfireEventLogHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint64_t seed;
+};
+
+static_assert(sizeof(WildfireEvent) == 16, "The event log record layout must not change");
+static_assert(sizeof(WildfireEventLogHeader) == 24, "The event log header layout must not change");
+
+constexpr uint32_t WILDFIRE_EVENT_LOG_MAGIC = 0x54564557; // "WEVT"
+// Version 2 added the UseSlope and UseVonNeumannNeighborhood parameters. Version 1 logs still
+// load, and replay with the slope and the von Neumann neighbourhood off unless they set them.
+constexpr uint32_t WILDFIRE_EVENT_LOG_VERSION = 2;
+constexpr uint32_t WILDFIRE_EVENT_LOG_MIN_VERSION = 1;
+
+float getWildfireParameter(const WildfireParameters& parameters, WildfireParameterId parameter);
+void setWildfireParameter(WildfireParameters& parameters, WildfireParameterId parameter, float value);
+
+// Apply a Parameter or Wind event to the parameters. Other events are ignored.
+void applyWildfireEvent(WildfireParameters& parameters, const WildfireEvent& event);
+
+// Appends events to a log file as they happen.
+class WildfireEventRecorder
+{
+public:
+    // Start a log for a width x height grid. The initial parameters are recorded at step 0,
+    // so a replay does not depend on the defaults of WildfireParameters.
+    bool open(const char* path, int width, int height, const WildfireParameters& parameters);
+
+    // Write the End event and close the file.
+    void close(uint32_t stepCount, float sessionSeconds);
+
+    bool isOpen() const { return file.is_open(); }
+
+    void recordIgnition(uint32_t step, glm::vec2 normalizedPos);
+
+    // Record every parameter which differs from the last recorded value.
+    void recordParameters(uint32_t step, const WildfireParameters& parameters);
+
+private:
+    void write(uint32_t step, WildfireEventType type, WildfireParameterId parameter, float x, float y);
+
+    std::ofstream file;
+    WildfireParameters recordedParameters;
+};
+
+// A decoded log. stepCount is the step of the End event, or one past the last event if the
+// session did not close the log.
+struct WildfireEventLog
+{
+    int width = 0;
+    int height = 0;
+    uint64_t seed = 0;
+    uint32_t stepCount = 0;
+    float sessionSeconds = 0.0f;
+
+    std::vector<WildfireEvent> events;
+};
+
+bool loadWildfireEventLog(const char* path, WildfireEventLog& outLog);
+
+#endif
@@ -0,0 +1,238 @@
+#include "WildfireGridFile.h"
+
+#include "WildfireDefinitions.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t alignGridFileOffset(uint64_t offset)
+{
+    return (offset + WildfireGridFile::GRID_FILE_ALIGNMENT - 1) / WildfireGridFile::GRID_FILE_ALIGNMENT * WildfireGridFile::GRID_FILE_ALIGNMENT;
+}
+
+bool WildfireGridFile::create(const char* path, const WildfireLandscape& landscape, int tileSize)
+{
+    if (tileSize <= 0 || landscape.width <= 0 || landscape.height <= 0) {
+        return false;
+    }
+
+    WildfireGridFileHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.width = landscape.width;
+    header.height = landscape.height;
+    header.tileSize = tileSize;
+    header.tileCountX = (landscape.width + tileSize - 1) / tileSize;
+    header.tileCountY = (landscape.height + tileSize - 1) / tileSize;
+    header.stepCount = 0;
+
+    const size_t tileCount = (size_t)header.tileCountX * header.tileCountY;
+    const uint64_t cellsPerTile = (uint64_t)tileSize * tileSize;
+
+    ////////////////////////////////////////////////////////////////////
+    /// LAY OUT THE TILE INDEX AND PLANES
+    ////////////////////////////////////////////////////////////////////
+
+    const uint64_t materialPlaneOffset = alignGridFileOffset(sizeof(WildfireGridFileHeader) + tileCount * sizeof(WildfireGridTile));
+    const uint64_t heightPlaneOffset = alignGridFileOffset(materialPlaneOffset + tileCount * cellsPerTile);
+    const uint64_t statePlaneOffset = alignGridFileOffset(heightPlaneOffset + tileCount * cellsPerTile * sizeof(uint16_t));
+    const uint64_t fileSize = statePlaneOffset + tileCount * cellsPerTile;
+
+    std::vector<WildfireGridTile> tiles(tileCount);
+    for (size_t tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        tiles[tileIndex].materialOffset = materialPlaneOffset + tileIndex * cellsPerTile;
+        tiles[tileIndex].heightOffset = heightPlaneOffset + tileIndex * cellsPerTile * sizeof(uint16_t);
+        tiles[tileIndex].stateOffset = statePlaneOffset + tileIndex * cellsPerTile;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// WRITE THE PLANES ONE TILE AT A TIME
+    ////////////////////////////////////////////////////////////////////
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create grid file: " << path << std::endl;
+        return false;
+    }
+
+    auto writeAt = [&](uint64_t offset, const void* bytes, size_t byteCount) {
+        file.seekp((std::streamoff)offset);
+        file.write((const char*)bytes, (std::streamsize)byteCount);
+    };
+
+    // Padding cells outside the grid are water at height 0.
+    std::vector<uint8_t> materialTile(cellsPerTile);
+    std::vector<uint16_t> heightTile(cellsPerTile);
+    const std::vector<uint8_t> stateTile(cellsPerTile, STATE_NOT_ON_FIRE);
+
+    for (size_t tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        WildfireGridTile& tile = tiles[tileIndex];
+
+        const int startX = (int)(tileIndex % header.tileCountX) * tileSize;
+        const int startY = (int)(tileIndex / header.tileCountX) * tileSize;
+
+        std::fill(materialTile.begin(), materialTile.end(), (uint8_t)MATERIAL_WATER);
+        std::fill(heightTile.begin(), heightTile.end(), (uint16_t)0);
+
+        for (int localY = 0; localY < tileSize && startY + localY < landscape.height; localY++) {
+            for (int localX = 0; localX < tileSize && startX + localX < landscape.width; localX++) {
+                const size_t cellIndex = (size_t)(startY + localY) * landscape.width + (startX + localX);
+                const size_t tileCellIndex = (size_t)localY * tileSize + localX;
+
+                materialTile[tileCellIndex] = landscape.materials[cellIndex];
+                heightTile[tileCellIndex] = landscape.heights[cellIndex];
+
+                tile.burnableCellCount += landscape.materials[cellIndex] != MATERIAL_WATER;
+            }
+        }
+
+        writeAt(tile.materialOffset, materialTile.data(), materialTile.size());
+        writeAt(tile.heightOffset, heightTile.data(), heightTile.size() * sizeof(uint16_t));
+        writeAt(tile.stateOffset, stateTile.data(), stateTile.size());
+    }
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(sizeof(header), tiles.data(), tiles.size() * sizeof(WildfireGridTile));
+
+    file.seekp(0, std::ios::end);
+    if (!file || (uint64_t)file.tellp() != fileSize) {
+        std::cerr << "Failed to write grid file: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+WildfireGridFile::~WildfireGridFile()
+{
+    close();
+}
+
+bool WildfireGridFile::open(const char* path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open grid file: " << path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        std::cerr << "Failed to map grid file: " << path << std::endl;
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = (uint8_t*)view;
+    size = (size_t)fileSize.QuadPart;
+#else
+    const int descriptor = ::open(path, O_RDWR);
+    if (descriptor < 0) {
+        std::cerr << "Failed to open grid file: " << path << std::endl;
+        return false;
+    }
+
+    struct stat fileStatus;
+    void* view = fstat(descriptor, &fileStatus) == 0 && fileStatus.st_size > 0
+        ? mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0)
+        : MAP_FAILED;
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map grid file: " << path << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+
+    fileDescriptor = descriptor;
+    data = (uint8_t*)view;
+    size = (size_t)fileStatus.st_size;
+#endif
+
+    ////////////////////////////////////////////////////////////////////
+    /// VALIDATE THE HEADER AND TILE INDEX
+    ////////////////////////////////////////////////////////////////////
+
+    bool bIsValid = size >= sizeof(WildfireGridFileHeader)
+        && getHeader().magic == MAGIC
+        && getHeader().version == VERSION
+        && getHeader().width > 0 && getHeader().height > 0 && getHeader().tileSize > 0
+        && getHeader().tileCountX == (getHeader().width + getHeader().tileSize - 1) / getHeader().tileSize
+        && getHeader().tileCountY == (getHeader().height + getHeader().tileSize - 1) / getHeader().tileSize
+        && size >= sizeof(WildfireGridFileHeader) + getTileCount() * sizeof(WildfireGridTile);
+
+    const uint64_t cellsPerTile = bIsValid ? (uint64_t)getTileSize() * getTileSize() : 0;
+    for (size_t tileIndex = 0; bIsValid && tileIndex < getTileCount(); tileIndex++) {
+        const WildfireGridTile& tile = getTile(tileIndex);
+        bIsValid = tile.materialOffset + cellsPerTile <= size
+            && tile.heightOffset + cellsPerTile * sizeof(uint16_t) <= size
+            && tile.stateOffset + cellsPerTile <= size
+            && tile.heightOffset % sizeof(uint16_t) == 0;
+    }
+
+    if (!bIsValid) {
+        std::cerr << "Not a valid grid file: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void WildfireGridFile::close()
+{
+    if (data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(data, size);
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
+
+void WildfireGridFile::flush()
+{
+    if (data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    FlushViewOfFile(data, 0);
+#else
+    msync(data, size, MS_ASYNC);
+#endif
+}
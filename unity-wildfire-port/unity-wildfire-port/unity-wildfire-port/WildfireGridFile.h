@@ -0,0 +1,124 @@
+#ifndef WILDFIRE_GRID_FILE_H
+#define WILDFIRE_GRID_FILE_H
+
+#include "WildfireLandscape.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+//
+// Chunked on-disk grid for landscapes which do not fit in memory. The grid is cut into
+// fixed-size square tiles, and each plane (material, height, state) is stored as its own
+// run of tiles, so the static planes are never written and a tile of one plane is a few
+// whole pages. The file is memory-mapped: only the tiles the simulation touches are paged in.
+//
+// Layout (little endian):
+//   WildfireGridFileHeader
+//   WildfireGridTile[tileCountX * tileCountY]   (the tile index, row major)
+//   material plane: tileSize * tileSize uint8 per tile
+//   height plane:   tileSize * tileSize uint16 per tile
+//   state plane:    tileSize * tileSize uint8 per tile
+//
+// Each plane starts on a GRID_FILE_ALIGNMENT boundary. Cells of edge tiles which lie outside
+// the grid are padding (water, not on fire) and are never stepped.
+//
+// ----------------------------------------------------------------------------
+
+struct WildfireGridFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t tileSize;
+    int32_t tileCountX;
+    int32_t tileCountY;
+
+    // Number of steps simulated on the state plane, so a run can resume with the same random numbers.
+    uint32_t stepCount;
+};
+
+// One entry of the tile index.
+struct WildfireGridTile
+{
+    // Byte offsets of the tile in each plane.
+    uint64_t materialOffset;
+    uint64_t heightOffset;
+    uint64_t stateOffset;
+
+    // Cells which are not water. Fire never enters a tile without any while water is not flammable.
+    uint32_t burnableCellCount;
+
+    // Kept up to date by the simulation so the fire can be found without reading the state plane.
+    uint32_t burningCellCount;
+    uint32_t destroyedCellCount;
+
+    uint32_t padding;
+};
+
+static_assert(sizeof(WildfireGridFileHeader) == 32, "The grid file header layout must not change");
+static_assert(sizeof(WildfireGridTile) == 40, "The grid file tile index layout must not change");
+
+class WildfireGridFile
+{
+public:
+    static constexpr uint32_t MAGIC = 0x44524757; // "WGRD"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int DEFAULT_TILE_SIZE = 64;
+    static constexpr uint64_t GRID_FILE_ALIGNMENT = 4096;
+
+    // Write a landscape (every cell not on fire) to a new grid file.
+    static bool create(const char* path, const WildfireLandscape& landscape, int tileSize = DEFAULT_TILE_SIZE);
+
+    WildfireGridFile() = default;
+    ~WildfireGridFile();
+
+    WildfireGridFile(const WildfireGridFile&) = delete;
+    WildfireGridFile& operator=(const WildfireGridFile&) = delete;
+
+    // Map an existing grid file for reading and writing. The state plane is simulated in place.
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // Write the dirty pages back to the file.
+    void flush();
+
+    int getWidth() const { return getHeader().width; }
+    int getHeight() const { return getHeader().height; }
+    int getTileSize() const { return getHeader().tileSize; }
+    int getTileCountX() const { return getHeader().tileCountX; }
+    int getTileCountY() const { return getHeader().tileCountY; }
+    size_t getTileCount() const { return (size_t)getTileCountX() * getTileCountY(); }
+
+    uint32_t getStepCount() const { return getHeader().stepCount; }
+    void setStepCount(uint32_t stepCount) { getHeader().stepCount = stepCount; }
+
+    WildfireGridTile& getTile(size_t tileIndex) { return getTiles()[tileIndex]; }
+    const WildfireGridTile& getTile(size_t tileIndex) const { return getTiles()[tileIndex]; }
+
+    // Row major tileSize x tileSize cells of one tile.
+    const uint8_t* getMaterialTile(size_t tileIndex) const { return data + getTile(tileIndex).materialOffset; }
+    const uint16_t* getHeightTile(size_t tileIndex) const { return (const uint16_t*)(data + getTile(tileIndex).heightOffset); }
+    uint8_t* getStateTile(size_t tileIndex) { return data + getTile(tileIndex).stateOffset; }
+    const uint8_t* getStateTile(size_t tileIndex) const { return data + getTile(tileIndex).stateOffset; }
+
+private:
+    WildfireGridFileHeader& getHeader() { return *(WildfireGridFileHeader*)data; }
+    const WildfireGridFileHeader& getHeader() const { return *(const WildfireGridFileHeader*)data; }
+    WildfireGridTile* getTiles() { return (WildfireGridTile*)(data + sizeof(WildfireGridFileHeader)); }
+    const WildfireGridTile* getTiles() const { return (const WildfireGridTile*)(data + sizeof(WildfireGridFileHeader)); }
+
+    uint8_t* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
+
+#endif
@@ -0,0 +1,673 @@
+#include "WildfireHeadless.h"
+
+#include "WildfireArrivalTime.h"
+#include "WildfireBranch.h"
+#include "WildfireEngine.h"
+#include "WildfireChunkedEngine.h"
+#include "WildfireEnsemble.h"
+#include "WildfireDeltaStream.h"
+#include "WildfireEventLog.h"
+#include "WildfireGridFile.h"
+#include "WildfireSnapshot.h"
+#include "WildfireStats.h"
+#include "WildfireTrace.h"
+#include "WildfireWindField.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+// Write the grid using the same colors as the terrain fragment shader (without height shading).
+static bool writeStateImage(const char* path, const std::vector<WildfireCell>& cells, int width, int height)
+{
+    std::vector<unsigned char> pixels(cells.size() * 3);
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        const int material = GetMaterial(cells[i]);
+        const int state = GetState(cells[i]);
+
+        unsigned char r = 0, g = 0, b = 255;
+        if (state == STATE_ON_FIRE) { r = 255; g = 119; b = 0; }
+        else if (state == STATE_DESTROYED) { r = 0; g = 0; b = 0; }
+        else if (material == MATERIAL_GRASS) { r = 121; g = 150; b = 114; }
+        else if (material == MATERIAL_WATER) { r = 181; g = 219; b = 235; }
+        else if (material == MATERIAL_BEDROCK) { r = 207; g = 198; b = 180; }
+        else if (material == MATERIAL_TREE_1) { r = 32; g = 99; b = 84; }
+        else if (material == MATERIAL_TREE_2) { r = 66; g = 143; b = 30; }
+        else if (material == MATERIAL_TREE_3) { r = 185; g = 209; b = 50; }
+
+        pixels[i * 3 + 0] = r;
+        pixels[i * 3 + 1] = g;
+        pixels[i * 3 + 2] = b;
+    }
+
+    // The grid was loaded flipped, so flip it back when writing.
+    stbi_flip_vertically_on_write(1);
+    return stbi_write_png(path, width, height, 3, pixels.data(), width * 3) != 0;
+}
+
+static bool writeStateImage(const char* path, const WildfireEngine& engine)
+{
+    return writeStateImage(path, engine.getCells(), engine.getWidth(), engine.getHeight());
+}
+
+// Write the burn probability as a greyscale image, white where every member burned.
+static bool writeBurnProbabilityImage(const char* path, const WildfireEnsemble& ensemble)
+{
+    const std::vector<float> burnProbability = ensemble.getBurnProbability();
+    std::vector<unsigned char> pixels(burnProbability.size());
+
+    for (size_t i = 0; i < burnProbability.size(); i++) {
+        pixels[i] = (unsigned char)(burnProbability[i] * 255.0f + 0.5f);
+    }
+
+    stbi_flip_vertically_on_write(1);
+    return stbi_write_png(path, ensemble.getWidth(), ensemble.getHeight(), 1, pixels.data(), ensemble.getWidth()) != 0;
+}
+
+// Every member runs the given rules. Member m takes the seed parameters.seed + m.
+static int runEnsemble(const WildfireLandscape& landscape, const WildfireParameters& parameters, int memberCount, int stepCount, unsigned int threadCount, glm::vec2 ignitionPos, const char* outputPath)
+{
+    WildfireEnsemble ensemble(landscape, memberCount, threadCount);
+    ensemble.parameters = parameters;
+    ensemble.ignite(ignitionPos);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < stepCount; i++) {
+        ensemble.step();
+    }
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const double totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    double expectedBurnedCells = 0.0;
+    for (float probability : ensemble.getBurnProbability()) {
+        expectedBurnedCells += probability;
+    }
+
+    std::cout << "Steps: " << stepCount << " for " << ensemble.getMemberCount() << " members on " << ensemble.getThreadCount() << " threads" << std::endl;
+    std::cout << "Time per step: " << (stepCount > 0 ? totalSeconds * 1000.0 / stepCount : 0.0) << " ms" << std::endl;
+    std::cout << "Expected burned cells: " << expectedBurnedCells << std::endl;
+
+    if (outputPath != nullptr && !writeBurnProbabilityImage(outputPath, ensemble)) {
+        std::cerr << "Failed to write burn probability image: " << outputPath << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// A what-if branch to fork: another wind, or a firebreak cut across the normalized rectangle.
+struct WildfireBranchRequest
+{
+    bool bHasWindAngle = false;
+    float windAngleDegrees = 0.0f;
+    glm::vec4 firebreak = glm::vec4(0.0f);
+};
+
+// "state.png" becomes "state_branch2.png".
+static std::string getBranchOutputPath(const char* outputPath, size_t branchIndex)
+{
+    const std::string path = outputPath;
+    const size_t extension = path.find_last_of('.');
+    const std::string suffix = "_branch" + std::to_string(branchIndex);
+    return extension == std::string::npos ? path + suffix : path.substr(0, extension) + suffix + path.substr(extension);
+}
+
+// Run the fire up to branchStep, fork one copy-on-write branch per request next to the unchanged
+// base, and run every branch to stepCount.
+static int runBranches(const WildfireLandscape& landscape, const WildfireParameters& parameters, int stepCount, unsigned int threadCount, glm::vec2 ignitionPos, bool bShouldIgnite,
+    int branchStep, const std::vector<WildfireBranchRequest>& requests, const char* outputPath)
+{
+    WildfireThreadPool threadPool(threadCount);
+
+    std::vector<WildfireBranch> branches;
+    branches.emplace_back(landscape, threadPool);
+    branches[0].parameters = parameters;
+    if (bShouldIgnite) {
+        branches[0].ignite(ignitionPos);
+    }
+
+    for (int i = 0; i < branchStep && i < stepCount; i++) {
+        branches[0].step();
+    }
+    const int forkStep = branches[0].getStepCount();
+
+    const auto forkStartTime = std::chrono::steady_clock::now();
+    branches.reserve(requests.size() + 1);
+    for (size_t i = 0; i < requests.size(); i++) {
+        branches.push_back(branches[0].fork());
+    }
+    const auto forkEndTime = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        WildfireBranch& branch = branches[i + 1];
+        if (requests[i].bHasWindAngle) {
+            branch.parameters.windDirectionIndex = WIND_DIRECTION_ANGLE;
+            branch.parameters.windAngleDegrees = requests[i].windAngleDegrees;
+        }
+        else {
+            const glm::vec2 gridSize = glm::vec2(branch.getWidth(), branch.getHeight());
+            branch.cutFirebreak(glm::ivec2(glm::vec2(requests[i].firebreak.x, requests[i].firebreak.y) * gridSize),
+                glm::ivec2(glm::vec2(requests[i].firebreak.z, requests[i].firebreak.w) * gridSize));
+        }
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (WildfireBranch& branch : branches) {
+        while (branch.getStepCount() < stepCount) {
+            branch.step();
+        }
+    }
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const double totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    // Tiles which no branch changed since the fork are held once.
+    std::unordered_set<const WildfireBranchTile*> distinctTiles;
+    for (const WildfireBranch& branch : branches) {
+        for (const std::shared_ptr<WildfireBranchTile>& tile : branch.getTiles()) {
+            distinctTiles.insert(tile.get());
+        }
+    }
+
+    std::cout << "Forked " << requests.size() << " branches at step " << forkStep << " in "
+        << std::chrono::duration<double>(forkEndTime - forkStartTime).count() * 1e6 << " us" << std::endl;
+    std::cout << "Steps: " << stepCount << " for " << branches.size() << " branches on " << threadPool.getThreadCount() << " threads in " << totalSeconds << " s" << std::endl;
+    std::cout << "Distinct tiles: " << distinctTiles.size() << " (" << branches[0].getTiles().size() << " per branch, "
+        << distinctTiles.size() * sizeof(WildfireBranchTile) / (1024 * 1024) << " MB for every branch)" << std::endl;
+
+    for (size_t branchIndex = 0; branchIndex < branches.size(); branchIndex++) {
+        const WildfireBranch& branch = branches[branchIndex];
+        std::cout << "Branch " << branchIndex << ": burning cells: " << branch.getBurningCellCount() << ", destroyed cells: " << branch.getDestroyedCellCount() << std::endl;
+
+        if (outputPath != nullptr) {
+            const std::string branchOutputPath = getBranchOutputPath(outputPath, branchIndex);
+            if (!writeStateImage(branchOutputPath.c_str(), branch.getCells(), branch.getWidth(), branch.getHeight())) {
+                std::cerr << "Failed to write state image: " << branchOutputPath << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Write arrival times either as raw little endian floats (.raw) or as a PNG which is white at the
+// ignition, darkens with later arrival and is black where the fire never arrives.
+static bool writeArrivalTimeFile(const char* path, const std::vector<float>& arrivalTimes, int width, int height, float lastArrivalTime)
+{
+    const size_t pathLength = std::strlen(path);
+    if (pathLength >= 4 && std::strcmp(path + pathLength - 4, ".raw") == 0) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write((const char*)arrivalTimes.data(), (std::streamsize)(arrivalTimes.size() * sizeof(float)));
+        return (bool)file;
+    }
+
+    std::vector<unsigned char> pixels(arrivalTimes.size(), 0);
+    for (size_t i = 0; i < arrivalTimes.size(); i++) {
+        if (arrivalTimes[i] != WILDFIRE_NEVER_BURNS) {
+            pixels[i] = (unsigned char)(255.0f - 223.0f * (lastArrivalTime > 0.0f ? arrivalTimes[i] / lastArrivalTime : 0.0f));
+        }
+    }
+
+    stbi_flip_vertically_on_write(1);
+    return stbi_write_png(path, width, height, 1, pixels.data(), width) != 0;
+}
+
+static int runArrivalTime(const WildfireLandscape& landscape, const WildfireParameters& parameters, glm::vec2 ignitionPos, int stepCount, const char* outputPath)
+{
+    WildfireArrivalTimeSettings settings;
+    if (stepCount > 0) {
+        settings.maxArrivalTime = (float)stepCount;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const std::vector<float> arrivalTimes = computeWildfireArrivalTimes(landscape, parameters, ignitionPos, settings);
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const double totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    size_t burnedCount = 0;
+    float lastArrivalTime = 0.0f;
+    for (float arrivalTime : arrivalTimes) {
+        if (arrivalTime != WILDFIRE_NEVER_BURNS) {
+            ++burnedCount;
+            lastArrivalTime = std::max(lastArrivalTime, arrivalTime);
+        }
+    }
+
+    std::cout << "Arrival times computed in " << totalSeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "Burned cells: " << burnedCount << ", last arrival: step " << lastArrivalTime << std::endl;
+
+    if (outputPath != nullptr && !writeArrivalTimeFile(outputPath, arrivalTimes, landscape.width, landscape.height, lastArrivalTime)) {
+        std::cerr << "Failed to write arrival times: " << outputPath << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Write the changes of the engine's last step. Does nothing unless the stream is open.
+static void writeLastStepChanges(const WildfireEngine& engine, WildfireDeltaStreamWriter& deltaStream)
+{
+    const std::vector<WildfireCellChange>& changes = engine.getLastStepChanges();
+    deltaStream.writeFrame((uint32_t)engine.getStepCount() - 1, 0, changes.data(), changes.size());
+}
+
+// Log the stats of the grid after the engine's last step. Does nothing unless the log is open.
+static void writeStats(WildfireEngine& engine, WildfireStatsCsvWriter& statsCsv)
+{
+    if (statsCsv.isOpen()) {
+        statsCsv.write(engine.computeStats());
+    }
+}
+
+// Step the engine through a recorded session as fast as it can: events apply at the step they
+// were logged at, and the last ignition of a step wins (the shader has a single mouse position).
+static void replayWildfireEventLog(WildfireEngine& engine, const WildfireEventLog& eventLog, WildfireDeltaStreamWriter& deltaStream, WildfireStatsCsvWriter& statsCsv)
+{
+    size_t eventIndex = 0;
+    while ((uint32_t)engine.getStepCount() < eventLog.stepCount) {
+        bool bIsMouseDown = false;
+        glm::vec2 mousePos = glm::vec2(0.0f, 0.0f);
+
+        for (; eventIndex < eventLog.events.size() && eventLog.events[eventIndex].step == (uint32_t)engine.getStepCount(); eventIndex++) {
+            const WildfireEvent& event = eventLog.events[eventIndex];
+            if (event.type == WildfireEventType::Ignite) {
+                bIsMouseDown = true;
+                mousePos = glm::vec2(event.x, event.y);
+            }
+            else {
+                applyWildfireEvent(engine.parameters, event);
+            }
+        }
+
+        engine.step(bIsMouseDown, mousePos);
+        writeLastStepChanges(engine, deltaStream);
+        writeStats(engine, statsCsv);
+    }
+}
+
+// Step a grid file in place. The landscape images are not needed, the file holds the whole scenario.
+static int runGridFile(const char* gridPath, int stepCount, unsigned int threadCount, uint64_t seed, bool bShouldIgnite, glm::vec2 ignitionPos)
+{
+    WildfireGridFile gridFile;
+    if (!gridFile.open(gridPath)) {
+        return -1;
+    }
+
+    WildfireChunkedEngine engine(gridFile, threadCount);
+    engine.parameters.seed = seed;
+    if (bShouldIgnite) {
+        engine.ignite(ignitionPos);
+    }
+
+    const int firstStep = engine.getStepCount();
+    size_t residentTileSteps = 0;
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < stepCount; i++) {
+        engine.step();
+        residentTileSteps += engine.getLastStepResidentTileCount();
+    }
+
+    gridFile.flush();
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const double totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << "Steps: " << firstStep << " to " << engine.getStepCount() << " of a " << engine.getWidth() << "x" << engine.getHeight() << " grid on " << engine.getThreadCount() << " threads" << std::endl;
+    std::cout << "Time per step: " << (stepCount > 0 ? totalSeconds * 1000.0 / stepCount : 0.0) << " ms" << std::endl;
+    std::cout << "Resident tiles per step: " << (stepCount > 0 ? (double)residentTileSteps / stepCount : 0.0) << " of " << gridFile.getTileCount() << std::endl;
+    std::cout << "Burning cells: " << engine.getBurningCellCount() << ", destroyed cells: " << engine.getDestroyedCellCount() << std::endl;
+
+    return 0;
+}
+
+// Writes the trace on every way out of the run, after the engine and its workers are gone.
+struct WildfireHeadlessTraceWriter
+{
+    const char* path = nullptr;
+
+    ~WildfireHeadlessTraceWriter()
+    {
+        if (path != nullptr) {
+            writeWildfireTrace(path);
+        }
+    }
+};
+
+int runWildfireHeadless(int argc, char* argv[], const char* landscapePath, const char* heightmapPath)
+{
+    setWildfireTraceThreadName("Main thread");
+    WildfireHeadlessTraceWriter traceWriter;
+
+    int width = 0;
+    int height = 0;
+    int stepCount = 1000;
+    unsigned int threadCount = 0;
+    glm::vec2 ignitionPos = glm::vec2(0.5f, 0.5f);
+    const char* outputPath = nullptr;
+    uint64_t seed = 0;
+    bool bUseWindAngle = false;
+    float windAngleDegrees = 0.0f;
+    const char* windFieldPath = nullptr;
+    bool bUseSlope = true;
+    bool bUseVonNeumannNeighborhood = false;
+    float fireProbability = 0.0f;
+    float grassRegrowProbability = 0.0f;
+    float treeRegrowProbability = 0.0f;
+    bool bUseLongHorizon = false;
+    int branchStep = -1;
+    std::vector<WildfireBranchRequest> branchRequests;
+    int memberCount = 0;
+    const char* gridPath = nullptr;
+    const char* writeGridPath = nullptr;
+    const char* loadSnapshotPath = nullptr;
+    const char* saveSnapshotPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* deltasPath = nullptr;
+    const char* statsPath = nullptr;
+    bool bShouldIgnite = true;
+    bool bComputeArrivalTime = false;
+    WildfireSteppingMode steppingMode = WildfireSteppingMode::Dense;
+
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            stepCount = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = (unsigned int)std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--ignite") == 0 && i + 2 < argc) {
+            ignitionPos.x = (float)std::atof(argv[++i]);
+            ignitionPos.y = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--active-front") == 0) {
+            steppingMode = WildfireSteppingMode::ActiveFront;
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+            width = std::atoi(argv[++i]);
+            height = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--wind-angle") == 0 && i + 1 < argc) {
+            bUseWindAngle = true;
+            windAngleDegrees = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--wind-field") == 0 && i + 1 < argc) {
+            windFieldPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--no-slope") == 0) {
+            bUseSlope = false;
+        }
+        else if (std::strcmp(argv[i], "--von-neumann") == 0) {
+            bUseVonNeumannNeighborhood = true;
+        }
+        else if (std::strcmp(argv[i], "--fire-probability") == 0 && i + 1 < argc) {
+            fireProbability = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--grass-regrow") == 0 && i + 1 < argc) {
+            grassRegrowProbability = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--tree-regrow") == 0 && i + 1 < argc) {
+            treeRegrowProbability = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--branch-at") == 0 && i + 1 < argc) {
+            branchStep = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--branch-wind") == 0 && i + 1 < argc) {
+            WildfireBranchRequest request;
+            request.bHasWindAngle = true;
+            request.windAngleDegrees = (float)std::atof(argv[++i]);
+            branchRequests.push_back(request);
+        }
+        else if (std::strcmp(argv[i], "--branch-firebreak") == 0 && i + 4 < argc) {
+            WildfireBranchRequest request;
+            request.firebreak.x = (float)std::atof(argv[++i]);
+            request.firebreak.y = (float)std::atof(argv[++i]);
+            request.firebreak.z = (float)std::atof(argv[++i]);
+            request.firebreak.w = (float)std::atof(argv[++i]);
+            branchRequests.push_back(request);
+        }
+        else if (std::strcmp(argv[i], "--long-horizon") == 0) {
+            bUseLongHorizon = true;
+            steppingMode = WildfireSteppingMode::ActiveFront;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--ensemble") == 0 && i + 1 < argc) {
+            memberCount = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+            gridPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--write-grid") == 0 && i + 1 < argc) {
+            writeGridPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--load-snapshot") == 0 && i + 1 < argc) {
+            loadSnapshotPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--save-snapshot") == 0 && i + 1 < argc) {
+            saveSnapshotPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceWriter.path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--deltas") == 0 && i + 1 < argc) {
+            deltasPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--arrival-time") == 0) {
+            bComputeArrivalTime = true;
+        }
+        else if (std::strcmp(argv[i], "--no-ignite") == 0) {
+            bShouldIgnite = false;
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown headless argument: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    if (gridPath != nullptr) {
+        return runGridFile(gridPath, stepCount, threadCount, seed, bShouldIgnite, ignitionPos);
+    }
+
+    // A replay runs on the grid the session was recorded on, from its initial landscape.
+    WildfireEventLog eventLog;
+    if (replayPath != nullptr) {
+        if (!loadWildfireEventLog(replayPath, eventLog)) {
+            return -1;
+        }
+
+        width = eventLog.width;
+        height = eventLog.height;
+        loadSnapshotPath = nullptr;
+    }
+
+    // A snapshot with a height plane holds the whole scenario, so the images are not needed.
+    WildfireSnapshot snapshot;
+    if (loadSnapshotPath != nullptr) {
+        const auto loadStartTime = std::chrono::steady_clock::now();
+        if (!loadWildfireSnapshot(loadSnapshotPath, snapshot)) {
+            return -1;
+        }
+        const auto loadEndTime = std::chrono::steady_clock::now();
+
+        std::cout << "Loaded snapshot at step " << snapshot.stepCount << " in " << std::chrono::duration<double>(loadEndTime - loadStartTime).count() * 1000.0 << " ms" << std::endl;
+    }
+
+    WildfireLandscape landscape;
+    if (!getWildfireSnapshotLandscape(snapshot, landscape)) {
+        // Load the grid exactly like the windowed path does.
+        stbi_set_flip_vertically_on_load(true);
+
+        if (!loadWildfireLandscape(landscapePath, heightmapPath, loadSnapshotPath != nullptr ? snapshot.width : width, loadSnapshotPath != nullptr ? snapshot.height : height, landscape)) {
+            return -1;
+        }
+    }
+
+    if (writeGridPath != nullptr) {
+        if (!WildfireGridFile::create(writeGridPath, landscape)) {
+            return -1;
+        }
+        std::cout << "Wrote a " << landscape.width << "x" << landscape.height << " grid file: " << writeGridPath << std::endl;
+        return 0;
+    }
+
+    // Every mode runs the rules the flags select.
+    WildfireParameters parameters;
+    parameters.seed = seed;
+    parameters.bUseSlope = bUseSlope;
+    parameters.bUseVonNeumannNeighborhood = bUseVonNeumannNeighborhood;
+    parameters.fireProbability = fireProbability;
+    parameters.grassRegrowProbability = grassRegrowProbability;
+    parameters.treeRegrowProbability = treeRegrowProbability;
+    if (bUseWindAngle) {
+        parameters.windDirectionIndex = WIND_DIRECTION_ANGLE;
+        parameters.windAngleDegrees = windAngleDegrees;
+    }
+
+    if (bComputeArrivalTime) {
+        return runArrivalTime(landscape, parameters, ignitionPos, stepCount, outputPath);
+    }
+
+    if (memberCount > 0) {
+        return runEnsemble(landscape, parameters, memberCount, stepCount, threadCount, ignitionPos, outputPath);
+    }
+
+    if (branchStep >= 0 || !branchRequests.empty()) {
+        return runBranches(landscape, parameters, stepCount, threadCount, ignitionPos, bShouldIgnite, std::max(branchStep, 0), branchRequests, outputPath);
+    }
+
+    WildfireEngine engine(landscape, threadCount);
+    engine.steppingMode = steppingMode;
+    engine.parameters = parameters;
+
+    WildfireWindField windField;
+    if (windFieldPath != nullptr) {
+        if (!windField.open(windFieldPath)) {
+            return -1;
+        }
+        engine.windField = &windField;
+    }
+
+    // Resume with the random numbers the snapshotted run would have drawn next.
+    if (loadSnapshotPath != nullptr) {
+        engine.setCells(snapshot.cells);
+        engine.setStepCount((int)snapshot.stepCount);
+        engine.parameters.seed = snapshot.seed;
+        if (!snapshot.timers.empty()) {
+            engine.setTimers(snapshot.timers);
+        }
+    }
+
+    if (bShouldIgnite && replayPath == nullptr) {
+        engine.ignite(ignitionPos);
+    }
+
+    WildfireDeltaStreamWriter deltaStream;
+    if (deltasPath != nullptr) {
+        if (!deltaStream.open(deltasPath, engine.getWidth(), engine.getHeight())) {
+            return -1;
+        }
+        engine.bRecordChanges = true;
+    }
+
+    WildfireStatsCsvWriter statsCsv;
+    if (statsPath != nullptr && !statsCsv.open(statsPath)) {
+        return -1;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    int skippedStepCount = 0;
+    if (replayPath != nullptr) {
+        engine.parameters.seed = eventLog.seed;
+        replayWildfireEventLog(engine, eventLog, deltaStream, statsCsv);
+        stepCount = engine.getStepCount();
+    }
+    else if (bUseLongHorizon) {
+        // Fires run step by step, the quiet periods between them are jumped over.
+        const int endStep = engine.getStepCount() + stepCount;
+        while (engine.getStepCount() < endStep) {
+            const int skipped = engine.skipQuietSteps(endStep - engine.getStepCount());
+            if (skipped == 0) {
+                engine.step();
+            }
+            skippedStepCount += skipped;
+
+            writeLastStepChanges(engine, deltaStream);
+            writeStats(engine, statsCsv);
+        }
+    }
+    else {
+        for (int i = 0; i < stepCount; i++) {
+            engine.step();
+            writeLastStepChanges(engine, deltaStream);
+            writeStats(engine, statsCsv);
+        }
+    }
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const double totalSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    if (replayPath != nullptr && eventLog.sessionSeconds > 0.0f) {
+        std::cout << "Replayed " << eventLog.events.size() << " events of a " << eventLog.sessionSeconds << " s session in " << totalSeconds << " s ("
+            << eventLog.sessionSeconds / totalSeconds << "x)" << std::endl;
+    }
+
+    size_t burningCount = 0;
+    size_t destroyedCount = 0;
+    for (const WildfireCell& cell : engine.getCells()) {
+        burningCount += GetState(cell) == STATE_ON_FIRE;
+        destroyedCount += GetState(cell) == STATE_DESTROYED;
+    }
+
+    std::cout << "Steps: " << stepCount << " to " << engine.getStepCount() << " on " << engine.getThreadCount() << " threads" << std::endl;
+    std::cout << "Time per step: " << (stepCount > 0 ? totalSeconds * 1000.0 / stepCount : 0.0) << " ms" << std::endl;
+    std::cout << "Burning cells: " << burningCount << ", destroyed cells: " << destroyedCount << std::endl;
+    if (bUseLongHorizon) {
+        std::cout << "Quiet steps jumped over: " << skippedStepCount << " of " << stepCount << std::endl;
+    }
+
+    if (outputPath != nullptr && !writeStateImage(outputPath, engine)) {
+        std::cerr << "Failed to write state image: " << outputPath << std::endl;
+        return -1;
+    }
+
+    if (saveSnapshotPath != nullptr) {
+        const auto saveStartTime = std::chrono::steady_clock::now();
+        if (!saveWildfireSnapshot(saveSnapshotPath, engine.getWidth(), engine.getHeight(), (uint32_t)engine.getStepCount(), engine.parameters.seed, engine.getCells().data(), engine.getHeights().data(), engine.hasTimers() ? engine.getTimers().data() : nullptr)) {
+            return -1;
+        }
+        const auto saveEndTime = std::chrono::steady_clock::now();
+
+        std::cout << "Saved snapshot at step " << engine.getStepCount() << " in " << std::chrono::duration<double>(saveEndTime - saveStartTime).count() * 1000.0 << " ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef WILDFIRE_HEADLESS_H
+#define WILDFIRE_HEADLESS_H
+
+// Entry point for `--headless`: runs the CPU engine without a window, configured by the
+// command line arguments that follow the flag.
+//
+//   --steps N             Number of steps to run (default 1000).
+//   --threads N           Worker threads, 0 for every hardware thread (default 0).
+//   --ignite X Y          Start a fire at a normalized grid position (default 0.5 0.5).
+//   --active-front        Only step the fire front instead of the whole grid.
+//   --size W H            Resample the inputs to a W x H grid (default: the landscape image size).
+//   --seed N              Seed of the random numbers (default 0).
+//   --wind-angle DEG      Blow the wind along DEG degrees counter-clockwise from east instead of northwest.
+//   --wind-field FILE     Take the wind from a gridded forecast manifest (see WildfireWindField.h).
+//   --no-slope            Spread as fast downhill as uphill.
+//   --von-neumann         Spread only across cell edges.
+//   --fire-probability P  Per step probability that a cell rolls for spontaneous ignition (default 0).
+//   --grass-regrow P      Per step probability that a burnt cell regrows as grass (default 0).
+//   --tree-regrow P       Per step probability that a grass cell grows into a tree (default 0).
+//   --branch-at N         Run to step N, then fork copy-on-write what-if branches (see
+//                         WildfireBranch.h) and run each to --steps. --output gets one image per branch.
+//   --branch-wind DEG     Fork a branch whose wind blows along DEG degrees (repeatable).
+//   --branch-firebreak X0 Y0 X1 Y1
+//                         Fork a branch with a firebreak cut across a normalized rectangle (repeatable).
+//   --long-horizon        Step only the fire front, and jump over quiet periods to the next
+//                         ignition (e.g. --steps 876000 for a century of hourly steps).
+//   --ensemble N          Step N realizations together and write their burn probability instead.
+//   --arrival-time        Compute the fire arrival time of every cell up to --steps in one pass.
+//   --write-grid FILE     Convert the landscape inputs to a chunked grid file and exit.
+//   --grid FILE           Step a chunked grid file in place, paging in only the tiles near the fire.
+//   --no-ignite           Do not start a fire (e.g. to continue a grid file run or a snapshot).
+//   --load-snapshot FILE  Resume from a snapshot (its step count and seed) instead of a fresh grid.
+//   --save-snapshot FILE  Write a compressed snapshot of the final state, with the height plane.
+//   --replay FILE         Rerun a session's event log (wildfire.events) at full speed, on its grid and seed.
+//   --deltas FILE         Stream the cells each step changed to a file or named pipe.
+//   --stats FILE          Log burning cells, front perimeter and burned area per step as CSV.
+//   --trace FILE          Write the timing zones of the run as Chrome trace JSON (see WildfireTrace.h).
+//   --output FILE         Write the final state, burn probability or arrival times as a PNG
+//                         (arrival times can also be written as raw floats to a .raw file).
+int runWildfireHeadless(int argc, char* argv[], const char* landscapePath, const char* heightmapPath);
+
+#endif
@@ -0,0 +1,206 @@
+#include "WildfireLandscape.h"
+
+#include "WildfireRules.h"
+#include "WildfireTrace.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+#include "stb_image.h"
+
+bool classifyLandscapeColor(int r, int g, int b, int& outMaterial)
+{
+    if (r == 181 && g == 219 && b == 235) {
+        outMaterial = MATERIAL_WATER;
+    }
+    else if (r == 207 && g == 198 && b == 180) {
+        outMaterial = MATERIAL_BEDROCK;
+    }
+    else if (r == 121 && g == 150 && b == 114) {
+        outMaterial = MATERIAL_GRASS;
+    }
+    else if (r == 32 && g == 99 && b == 84) {
+        outMaterial = MATERIAL_TREE_1;
+    }
+    else if (r == 66 && g == 143 && b == 30) {
+        outMaterial = MATERIAL_TREE_2;
+    }
+    else if (r == 185 && g == 209 && b == 50) {
+        outMaterial = MATERIAL_TREE_3;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+bool isTreeMaterial(int material)
+{
+    return material == MATERIAL_TREE_1 || material == MATERIAL_TREE_2 || material == MATERIAL_TREE_3;
+}
+
+// Bilinearly sample a single channel 16-bit image at a normalized (0-1) position (texel centers at (i + 0.5) / size).
+static uint16_t sampleHeightBilinear(const stbi_us* image, int imageWidth, int imageHeight, float u, float v)
+{
+    const float x = glm::clamp(u * imageWidth - 0.5f, 0.0f, (float)(imageWidth - 1));
+    const float y = glm::clamp(v * imageHeight - 0.5f, 0.0f, (float)(imageHeight - 1));
+
+    const int x0 = (int)x;
+    const int y0 = (int)y;
+    const int x1 = std::min(x0 + 1, imageWidth - 1);
+    const int y1 = std::min(y0 + 1, imageHeight - 1);
+    const float fx = x - x0;
+    const float fy = y - y0;
+
+    const float top = glm::mix((float)image[(size_t)y0 * imageWidth + x0], (float)image[(size_t)y0 * imageWidth + x1], fx);
+    const float bottom = glm::mix((float)image[(size_t)y1 * imageWidth + x0], (float)image[(size_t)y1 * imageWidth + x1], fx);
+
+    return (uint16_t)(glm::mix(top, bottom, fy) + 0.5f);
+}
+
+bool loadWildfireLandscape(const char* landscapePath, const char* heightmapPath, int width, int height, WildfireLandscape& outLandscape)
+{
+    WILDFIRE_TRACE_ZONE("loadWildfireLandscape");
+
+    ////////////////////////////////////////////////////////////////////
+    /// READ FROM HEIGHTMAP TEXTURE
+    ////////////////////////////////////////////////////////////////////
+
+    // Read 16 bits per pixel so 16-bit heightmaps keep their full precision (8-bit images are scaled up).
+    WildfireTraceZone heightmapDecodeZone("Decode heightmap image");
+    int heightmap_img_width, heightmap_img_height, heightmap_channels;
+    stbi_us* heightmap_image_data = stbi_load_16(heightmapPath, &heightmap_img_width, &heightmap_img_height, &heightmap_channels, STBI_grey);
+    heightmapDecodeZone.end();
+
+    if (!heightmap_image_data) {
+        std::cerr << "Failed to load heightmap image: " << heightmapPath << std::endl;
+        return false;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// READ FROM LANDSCAPE TEXTURE
+    ////////////////////////////////////////////////////////////////////
+
+    WildfireTraceZone landscapeDecodeZone("Decode landscape image");
+    int landscape_img_width, landscape_img_height, landscape_channels;
+    unsigned char* landscape_image_data = stbi_load(landscapePath, &landscape_img_width, &landscape_img_height, &landscape_channels, STBI_rgb);
+    landscapeDecodeZone.end();
+
+    if (!landscape_image_data) {
+        std::cerr << "Failed to load landscape image: " << landscapePath << std::endl;
+        stbi_image_free(heightmap_image_data);
+        return false;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    /// CLASSIFY EVERY CELL
+    ////////////////////////////////////////////////////////////////////
+
+    // The grid follows the landscape image unless a size was requested.
+    if (width <= 0 || height <= 0) {
+        width = landscape_img_width;
+        height = landscape_img_height;
+    }
+
+    const bool bIsLandscapeResampled = landscape_img_width != width || landscape_img_height != height;
+    const bool bIsHeightmapResampled = heightmap_img_width != width || heightmap_img_height != height;
+
+    if (bIsLandscapeResampled || bIsHeightmapResampled) {
+        std::cout << "Resampling landscape (" << landscape_img_width << "x" << landscape_img_height << ") and heightmap ("
+            << heightmap_img_width << "x" << heightmap_img_height << ") to a " << width << "x" << height << " grid" << std::endl;
+    }
+
+    WILDFIRE_TRACE_ZONE("Classify landscape");
+
+    const size_t pixelCount = (size_t)width * height;
+
+    outLandscape.width = width;
+    outLandscape.height = height;
+    outLandscape.materials.assign(pixelCount, MATERIAL_GRASS);
+    outLandscape.heights.assign(pixelCount, 0);
+
+    for (int pixel_y = 0; pixel_y < height; pixel_y++) {
+        for (int pixel_x = 0; pixel_x < width; pixel_x++) {
+            const size_t pixel_index = (size_t)pixel_y * width + pixel_x;
+
+            // Normalized position of the cell center, used to sample inputs of another resolution.
+            const float u = (pixel_x + 0.5f) / width;
+            const float v = (pixel_y + 0.5f) / height;
+
+            // Materials are categories, so take the nearest landscape pixel rather than blending colors.
+            const int landscape_x = bIsLandscapeResampled ? std::min((int)(u * landscape_img_width), landscape_img_width - 1) : pixel_x;
+            const int landscape_y = bIsLandscapeResampled ? std::min((int)(v * landscape_img_height), landscape_img_height - 1) : pixel_y;
+
+            // Determine the color value of the corresponding landscape image pixel.
+            // The image was requested as STBI_rgb, so the data always has 3 channels regardless of the file.
+            const size_t landscape_image_index = ((size_t)landscape_y * landscape_img_width + landscape_x) * STBI_rgb;
+
+            int r = (int)landscape_image_data[landscape_image_index];     // Red channel
+            int g = (int)landscape_image_data[landscape_image_index + 1]; // Green channel
+            int b = (int)landscape_image_data[landscape_image_index + 2]; // Blue channel
+
+            int material;
+            if (classifyLandscapeColor(r, g, b, material)) {
+                outLandscape.materials[pixel_index] = (unsigned char)material;
+            }
+
+            if (bIsHeightmapResampled) {
+                outLandscape.heights[pixel_index] = sampleHeightBilinear(heightmap_image_data, heightmap_img_width, heightmap_img_height, u, v);
+            }
+            else {
+                outLandscape.heights[pixel_index] = heightmap_image_data[pixel_index];
+            }
+        }
+    }
+
+    stbi_image_free(heightmap_image_data);
+    stbi_image_free(landscape_image_data);
+
+    return true;
+}
+
+std::vector<uint32_t> computeWildfireSlopeFactors(const WildfireLandscape& landscape, float heightScale, float cellSize, float slopeSpreadFactor)
+{
+    WILDFIRE_TRACE_ZONE("computeWildfireSlopeFactors");
+
+    std::vector<uint32_t> slopeFactors((size_t)landscape.width * landscape.height, 0);
+    if (slopeSpreadFactor <= 0.0f) {
+        return slopeFactors;
+    }
+
+    const float heightToWorld = heightScale / 65535.0f;
+
+    for (int y = 0; y < landscape.height; y++) {
+        for (int x = 0; x < landscape.width; x++) {
+            const size_t cellIndex = (size_t)y * landscape.width + x;
+            uint32_t packed = 0;
+
+            for (int neighbor = 0; neighbor < NUM_NEIGHBORS; neighbor++) {
+                const glm::ivec2 offset = GetNeighborOffset(neighbor);
+                const int neighborX = x + offset.x;
+                const int neighborY = y + offset.y;
+                if (neighborX < 0 || neighborY < 0 || neighborX >= landscape.width || neighborY >= landscape.height) {
+                    continue;
+                }
+
+                // The fire climbs from the neighbour into this cell.
+                const float rise = ((float)landscape.heights[cellIndex] - (float)landscape.heights[(size_t)neighborY * landscape.width + neighborX]) * heightToWorld;
+                if (rise <= 0.0f) {
+                    continue;
+                }
+
+                const float slope = rise / (glm::length(glm::vec2(offset)) * cellSize);
+                const float multiplier = 1.0f + slopeSpreadFactor * slope * slope;
+                const uint32_t level = (uint32_t)std::min((multiplier - 1.0f) / SLOPE_MULTIPLIER_STEP + 0.5f, (float)MAX_SLOPE_MULTIPLIER_LEVEL);
+                packed |= level << (4 * neighbor);
+            }
+
+            slopeFactors[cellIndex] = packed;
+        }
+    }
+
+    return slopeFactors;
+}
@@ -0,0 +1,47 @@
+#ifndef WILDFIRE_LANDSCAPE_H
+#define WILDFIRE_LANDSCAPE_H
+
+#include "WildfireDefinitions.h"
+
+#include <cstdint>
+#include <vector>
+
+// The static inputs of the simulation, classified from the landscape and heightmap images.
+struct WildfireLandscape
+{
+    int width = 0;
+    int height = 0;
+
+    // One material per cell (MATERIAL_*).
+    std::vector<unsigned char> materials;
+
+    // One world height per cell, normalized to 0-65535. This plane is static and uploaded once.
+    std::vector<uint16_t> heights;
+};
+
+// World units of a full (65535) height and of one cell, to turn the height plane into slopes.
+// These match the terrain mesh and tree placement of the windowed build.
+constexpr float WILDFIRE_HEIGHT_SCALE = 768.0f;
+constexpr float WILDFIRE_CELL_SIZE = 1.0f;
+
+// Upslope spread is multiplied by 1 + WILDFIRE_SLOPE_SPREAD_FACTOR * tan(slope)^2 (the shape
+// of Rothermel's slope factor).
+constexpr float WILDFIRE_SLOPE_SPREAD_FACTOR = 5.275f;
+
+// Map a landscape image color to its material. Returns false if the color is not a known material.
+bool classifyLandscapeColor(int r, int g, int b, int& outMaterial);
+
+// Returns true for any of the tree materials.
+bool isTreeMaterial(int material);
+
+// Load the landscape and heightmap images and classify every cell of a width x height grid.
+// A width or height of 0 sizes the grid to the landscape image. Inputs of a different resolution
+// are resampled: materials by nearest neighbour, heights bilinearly.
+bool loadWildfireLandscape(const char* landscapePath, const char* heightmapPath, int width, int height, WildfireLandscape& outLandscape);
+
+// The upslope spread multiplier from each of the 8 neighbours of every cell, quantized to 4 bits
+// and packed into one uint per cell (see GetSlopeMultiplier). The heights never change, so this
+// static plane is built once and the spread rule pays one load instead of eight heights.
+std::vector<uint32_t> computeWildfireSlopeFactors(const WildfireLandscape& landscape, float heightScale = WILDFIRE_HEIGHT_SCALE, float cellSize = WILDFIRE_CELL_SIZE, float slopeSpreadFactor = WILDFIRE_SLOPE_SPREAD_FACTOR);
+
+#endif
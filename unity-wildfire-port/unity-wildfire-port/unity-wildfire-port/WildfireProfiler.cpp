@@ -0,0 +1,198 @@
+#include "WildfireProfiler.h"
+
+#include <imgui.h>
+
+#include <cfloat>
+
+static float getMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+// The latest and the average value of a history ring.
+static void getHistoryTimes(const std::vector<float>& history, int offset, float& outLatest, float& outAverage)
+{
+    float sum = 0.0f;
+    for (float value : history) {
+        sum += value;
+    }
+
+    outLatest = history[(offset + (int)history.size() - 1) % (int)history.size()];
+    outAverage = sum / (float)history.size();
+}
+
+int WildfireProfiler::addPass(const char* name)
+{
+    Pass pass;
+    pass.name = name;
+    pass.gpuHistory.assign(HISTORY_LENGTH, 0.0f);
+    pass.cpuHistory.assign(HISTORY_LENGTH, 0.0f);
+    passes.push_back(pass);
+
+    return (int)passes.size() - 1;
+}
+
+void WildfireProfiler::create()
+{
+    for (Pass& pass : passes) {
+        glGenQueries(NUM_FRAMES_IN_FLIGHT, pass.queries);
+    }
+
+    frameCpuHistory.assign(HISTORY_LENGTH, 0.0f);
+    bIsCreated = true;
+}
+
+void WildfireProfiler::destroy()
+{
+    if (!bIsCreated) {
+        return;
+    }
+
+    for (Pass& pass : passes) {
+        glDeleteQueries(NUM_FRAMES_IN_FLIGHT, pass.queries);
+    }
+
+    bIsCreated = false;
+}
+
+void WildfireProfiler::beginFrame()
+{
+    if (!bIsCreated) {
+        return;
+    }
+
+    // Frames finish in order, oldest first. The oldest one's queries are about to be reused,
+    // so it is dropped if still pending; the frames after it may be ready regardless.
+    currentFrameSlot = (currentFrameSlot + 1) % NUM_FRAMES_IN_FLIGHT;
+    for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; i++) {
+        const int frameSlot = (currentFrameSlot + i) % NUM_FRAMES_IN_FLIGHT;
+        if (bIsPending[frameSlot] && !collectFrame(frameSlot, i == 0) && i > 0) {
+            break;
+        }
+    }
+
+    for (Pass& pass : passes) {
+        pass.bIsIssued[currentFrameSlot] = false;
+        pass.cpuMilliseconds = 0.0f;
+    }
+
+    frameStartTime = Clock::now();
+    bIsInFrame = true;
+}
+
+void WildfireProfiler::endFrame()
+{
+    if (!bIsInFrame) {
+        return;
+    }
+
+    bIsInFrame = false;
+    bIsPending[currentFrameSlot] = true;
+
+    for (Pass& pass : passes) {
+        pushHistory(pass.cpuHistory, pass.cpuHistoryOffset, pass.cpuMilliseconds);
+    }
+    pushHistory(frameCpuHistory, frameCpuHistoryOffset, getMilliseconds(Clock::now() - frameStartTime));
+}
+
+void WildfireProfiler::beginPass(int passIndex)
+{
+    if (!bIsInFrame) {
+        return;
+    }
+
+    Pass& pass = passes[passIndex];
+    glBeginQuery(GL_TIME_ELAPSED, pass.queries[currentFrameSlot]);
+    pass.cpuStartTime = Clock::now();
+}
+
+void WildfireProfiler::endPass(int passIndex)
+{
+    if (!bIsInFrame) {
+        return;
+    }
+
+    Pass& pass = passes[passIndex];
+    glEndQuery(GL_TIME_ELAPSED);
+    pass.bIsIssued[currentFrameSlot] = true;
+    pass.cpuMilliseconds = getMilliseconds(Clock::now() - pass.cpuStartTime);
+}
+
+bool WildfireProfiler::collectFrame(int frameSlot, bool bShouldDrop)
+{
+    for (const Pass& pass : passes) {
+        if (!pass.bIsIssued[frameSlot]) {
+            continue;
+        }
+
+        GLint bIsAvailable = GL_FALSE;
+        glGetQueryObjectiv(pass.queries[frameSlot], GL_QUERY_RESULT_AVAILABLE, &bIsAvailable);
+        if (bIsAvailable == GL_FALSE) {
+            if (bShouldDrop) {
+                bIsPending[frameSlot] = false;
+                ++droppedFrameCount;
+            }
+            return false;
+        }
+    }
+
+    for (Pass& pass : passes) {
+        GLuint64 nanoseconds = 0;
+        if (pass.bIsIssued[frameSlot]) {
+            glGetQueryObjectui64v(pass.queries[frameSlot], GL_QUERY_RESULT, &nanoseconds);
+        }
+        pushHistory(pass.gpuHistory, pass.gpuHistoryOffset, (float)(nanoseconds * 1e-6));
+    }
+
+    bIsPending[frameSlot] = false;
+    return true;
+}
+
+void WildfireProfiler::pushHistory(std::vector<float>& history, int& offset, float value)
+{
+    history[offset] = value;
+    offset = (offset + 1) % (int)history.size();
+}
+
+void WildfireProfiler::drawOverlay() const
+{
+    if (!bIsCreated) {
+        return;
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    if (!ImGui::Begin("Frame profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::End();
+        return;
+    }
+
+    float frameLatest, frameAverage;
+    getHistoryTimes(frameCpuHistory, frameCpuHistoryOffset, frameLatest, frameAverage);
+    ImGui::Text("%.1f FPS   frame CPU %.2f ms (avg %.2f)", ImGui::GetIO().Framerate, frameLatest, frameAverage);
+    if (droppedFrameCount > 0) {
+        ImGui::Text("%u GPU frames dropped", droppedFrameCount);
+    }
+
+    float gpuTotal = 0.0f;
+    for (const Pass& pass : passes) {
+        float gpuLatest, gpuAverage, cpuLatest, cpuAverage;
+        getHistoryTimes(pass.gpuHistory, pass.gpuHistoryOffset, gpuLatest, gpuAverage);
+        getHistoryTimes(pass.cpuHistory, pass.cpuHistoryOffset, cpuLatest, cpuAverage);
+        gpuTotal += gpuAverage;
+
+        ImGui::Separator();
+        ImGui::Text("%s", pass.name.c_str());
+        ImGui::Text("GPU %6.3f ms (avg %6.3f)   CPU %6.3f ms (avg %6.3f)", gpuLatest, gpuAverage, cpuLatest, cpuAverage);
+
+        ImGui::PushID(pass.name.c_str());
+        ImGui::PlotLines("GPU", pass.gpuHistory.data(), (int)pass.gpuHistory.size(), pass.gpuHistoryOffset, nullptr, 0.0f, FLT_MAX, ImVec2(300.0f, 40.0f));
+        ImGui::PlotLines("CPU", pass.cpuHistory.data(), (int)pass.cpuHistory.size(), pass.cpuHistoryOffset, nullptr, 0.0f, FLT_MAX, ImVec2(300.0f, 40.0f));
+        ImGui::PopID();
+    }
+
+    ImGui::Separator();
+    ImGui::Text("GPU total %.3f ms (avg)", gpuTotal);
+
+    ImGui::End();
+}
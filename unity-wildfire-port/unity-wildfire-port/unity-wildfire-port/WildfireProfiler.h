@@ -0,0 +1,87 @@
+#ifndef WILDFIRE_PROFILER_H
+#define WILDFIRE_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// GPU and CPU time of each pass of a frame. Every pass is bracketed by a GL_TIME_ELAPSED query
+// from a pool of NUM_FRAMES_IN_FLIGHT sets of queries, one set per frame. A frame's results are
+// only read once the GPU has made them available, so the profiler never waits on the GPU.
+// A set still pending when its frame comes around again is dropped instead.
+//
+// Timer queries cannot nest, so passes must not overlap. A pass runs at most once per frame
+// and may be skipped.
+//
+// ----------------------------------------------------------------------------
+
+class WildfireProfiler
+{
+public:
+    static constexpr int NUM_FRAMES_IN_FLIGHT = 4;
+    static constexpr int HISTORY_LENGTH = 240;
+
+    // Add the passes before create(). Returns the pass index for beginPass and endPass.
+    int addPass(const char* name);
+
+    // Create the query pool. Needs the OpenGL context.
+    void create();
+    void destroy();
+
+    // Collect every finished frame, then start timing a new one.
+    void beginFrame();
+    void endFrame();
+
+    void beginPass(int pass);
+    void endPass(int pass);
+
+    // An ImGui window with the latest and average times of every pass and their history graphs.
+    // Call between ImGui::NewFrame and ImGui::Render.
+    void drawOverlay() const;
+
+    // GPU frames dropped because their queries were not ready in time.
+    unsigned int getDroppedFrameCount() const { return droppedFrameCount; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pass
+    {
+        std::string name;
+
+        // Milliseconds per frame, oldest first from historyOffset. Frames which skipped the pass count 0.
+        std::vector<float> gpuHistory;
+        std::vector<float> cpuHistory;
+        int gpuHistoryOffset = 0;
+        int cpuHistoryOffset = 0;
+
+        GLuint queries[NUM_FRAMES_IN_FLIGHT] = {};
+        bool bIsIssued[NUM_FRAMES_IN_FLIGHT] = {};
+
+        Clock::time_point cpuStartTime;
+        float cpuMilliseconds = 0.0f;
+    };
+
+    // Read the queries of a frame if all of them are available. Returns false if some are still pending.
+    bool collectFrame(int frameSlot, bool bShouldDrop);
+
+    static void pushHistory(std::vector<float>& history, int& offset, float value);
+
+    std::vector<Pass> passes;
+    bool bIsPending[NUM_FRAMES_IN_FLIGHT] = {};
+    int currentFrameSlot = 0;
+    bool bIsCreated = false;
+    bool bIsInFrame = false;
+
+    Clock::time_point frameStartTime;
+    std::vector<float> frameCpuHistory;
+    int frameCpuHistoryOffset = 0;
+
+    unsigned int droppedFrameCount = 0;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef WILDFIRE_RANDOM_H
+#define WILDFIRE_RANDOM_H
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+//
+// Counter-based random numbers (Philox4x32-10, Salmon et al. 2011). Every draw is a pure
+// function of (seed, step, cell, draw index), so a run gives bit-identical results no
+// matter the frame rate, thread count or the order tiles are processed in. The compute
+// shader implements the same function (PhiloxRandom in Shaders/wildfireCompute.cs).
+//
+// ----------------------------------------------------------------------------
+
+// Draw indices within one cell step. Draws 0-3 come from one Philox block and 4-7 from the next.
+#define RANDOM_DRAW_TREE_REGROW 0
+#define RANDOM_DRAW_WIND_SPREAD 1
+#define RANDOM_DRAW_FIRE_CATCH 2
+#define RANDOM_DRAW_FLAMMABLE 3
+#define RANDOM_DRAW_BURNOUT 4
+#define RANDOM_DRAW_GRASS_REGROW 5
+#define RANDOM_DRAW_TIMER 6
+#define RANDOM_DRAW_TIMER_RESAMPLE 7
+
+// Streams keep draws for different purposes apart even when their other counters collide.
+#define RANDOM_STREAM_CELL 0
+#define RANDOM_STREAM_GLOBAL 1
+#define RANDOM_STREAM_IDLE_EVENTS 2
+#define RANDOM_STREAM_QUIET_STEPS 3
+
+// Cell index used for draws which belong to the whole grid (e.g. the temperature noise).
+#define RANDOM_GLOBAL_CELL 0xFFFFFFFFu
+
+struct PhiloxBlock
+{
+    uint32_t x, y, z, w;
+};
+
+inline void philoxMultiply(uint32_t a, uint32_t b, uint32_t& outHigh, uint32_t& outLow)
+{
+    const uint64_t product = (uint64_t)a * b;
+    outHigh = (uint32_t)(product >> 32);
+    outLow = (uint32_t)product;
+}
+
+// Philox4x32 with 10 rounds. Branch free integer code, so loops over cells vectorize.
+inline PhiloxBlock philox4x32(uint32_t counter0, uint32_t counter1, uint32_t counter2, uint32_t counter3, uint32_t key0, uint32_t key1)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        uint32_t high0, low0, high1, low1;
+        philoxMultiply(0xD2511F53u, counter0, high0, low0);
+        philoxMultiply(0xCD9E8D57u, counter2, high1, low1);
+
+        counter0 = high1 ^ counter1 ^ key0;
+        counter1 = low1;
+        counter2 = high0 ^ counter3 ^ key1;
+        counter3 = low0;
+
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+
+    return PhiloxBlock{ counter0, counter1, counter2, counter3 };
+}
+
+// Map 32 random bits to [0, 1) with 24 bits of precision. Exact in float on both CPU and GPU.
+inline float randomBitsToFloat(uint32_t bits)
+{
+    return (float)(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// All four draws of one block of a (cell, step) pair.
+inline PhiloxBlock wildfireRandomBlock(uint64_t seed, uint32_t step, uint32_t cellIndex, uint32_t block, uint32_t stream = RANDOM_STREAM_CELL)
+{
+    return philox4x32(cellIndex, step, block, stream, (uint32_t)seed, (uint32_t)(seed >> 32));
+}
+
+inline float wildfireRandomFromBlock(const PhiloxBlock& block, uint32_t drawIndex)
+{
+    switch (drawIndex & 3u)
+    {
+    case 0: return randomBitsToFloat(block.x);
+    case 1: return randomBitsToFloat(block.y);
+    case 2: return randomBitsToFloat(block.z);
+    default: return randomBitsToFloat(block.w);
+    }
+}
+
+// A single uniform [0, 1) draw.
+inline float wildfireRandom(uint64_t seed, uint32_t step, uint32_t cellIndex, uint32_t drawIndex, uint32_t stream = RANDOM_STREAM_CELL)
+{
+    return wildfireRandomFromBlock(wildfireRandomBlock(seed, step, cellIndex, drawIndex >> 2, stream), drawIndex);
+}
+
+#endif
@@ -0,0 +1,725 @@
+#ifndef WILDFIRE_RULES_H
+#define WILDFIRE_RULES_H
+
+#include "WildfireDefinitions.h"
+#include "WildfireRandom.h"
+#include "WildfireWindField.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+// ----------------------------------------------------------------------------
+//
+// C++ port of the cell rules in Shaders/wildfireCompute.cs. Every function here
+// mirrors the shader function of the same name so the CPU engines and the compute
+// shader evolve the grid by the same rules.
+//
+// ----------------------------------------------------------------------------
+
+// One simulation cell, laid out exactly like a texel of the GL_RG8UI wildfire textures.
+// The height never changes, so it lives in a separate static plane (see WildfireLandscape::heights).
+struct WildfireCell
+{
+    uint8_t material;
+    uint8_t state;
+};
+
+static_assert(sizeof(WildfireCell) == 2, "WildfireCell must match the GL_RG8UI texel layout");
+
+// A cell which changed during a step, and its new value. Matches the uvec2 records the compute
+// shader appends to its change buffer: (cell index, material | state << 8).
+struct WildfireCellChange
+{
+    uint32_t index;
+    WildfireCell cell;
+};
+
+static_assert(sizeof(WildfireCellChange) == 8, "WildfireCellChange must match the compute shader's change records");
+
+// windDirectionIndex: 0 is no wind, 1-8 the compass directions of GetWindDirection, and
+// WIND_DIRECTION_ANGLE blows along windAngleDegrees.
+constexpr int WIND_DIRECTION_ANGLE = 9;
+constexpr int NUM_WIND_DIRECTIONS = 10;
+
+// Mirrors the uniforms of the wildfire compute shader.
+struct WildfireParameters
+{
+    int windDirectionIndex = 6;
+
+    // Counter-clockwise from east (+x), in degrees. Only used with WIND_DIRECTION_ANGLE.
+    float windAngleDegrees = 0.0f;
+
+    float fireProbability = 0.0f;
+    float flammableProbabilityForGrass = 0.01f;
+    float flammableProbabilityForWater = 0.0f;
+    float flammableProbabilityForBedrock = 0.1f;
+    float flammableProbabilityForTree = 0.75f;
+
+    float grassRegrowProbability = 0.0f;
+    float treeRegrowProbability = 0.0f;
+
+    bool bUseTemperature = true;
+    bool bUseWind = true;
+
+    // Let the fire run faster uphill (see computeWildfireSlopeFactors).
+    bool bUseSlope = true;
+
+    // Spread only from the four edge neighbours instead of all eight.
+    bool bUseVonNeumannNeighborhood = false;
+
+    // Key of the counter-based random numbers. The same seed always gives the same run.
+    uint64_t seed = 0;
+};
+
+// Lookup tables for the parts of the rules which only depend on the parameters, so a cell
+// costs one load instead of a loop of normalize/dot evaluations. Laid out like the compute
+// shader's rule table buffer (std430).
+struct WildfireRuleTable
+{
+    // Spread probability for each mask of burning neighbours (see GetBurningNeighborMask).
+    float spreadProbabilities[256];
+
+    // Flammable probability per material (MATERIAL_*).
+    float flammableProbabilities[MATERIAL_COUNT];
+};
+
+static_assert(sizeof(WildfireRuleTable) == (256 + MATERIAL_COUNT) * sizeof(float), "WildfireRuleTable must match the compute shader's rule table buffer");
+
+// Per step inputs which are the same for every cell.
+struct WildfireStepContext
+{
+    // Number of steps simulated before this one. Together with the seed it keys every random draw.
+    uint32_t step = 0;
+
+    bool bIsMouseDown = false;
+    glm::vec2 mousePos = glm::vec2(0.0f, 0.0f);
+
+    // The size of the grid (gl_NumWorkGroups.xy in the shader).
+    glm::ivec2 gridSize = glm::ivec2(0, 0);
+
+    // CalculateTemperature() does not depend on the cell, so it is evaluated once per step.
+    float temperature = 20.0f;
+
+    // Built from the step's parameters (see WildfireRuleTableCache).
+    const WildfireRuleTable* ruleTable = nullptr;
+
+    // Replaces the global wind of the parameters when set, already updated to this step.
+    const WildfireWindField* windField = nullptr;
+
+    // Packed per-neighbour slope multipliers of every cell (computeWildfireSlopeFactors), or
+    // nullptr to ignore the terrain.
+    const uint32_t* slopeFactors = nullptr;
+
+    // Per-cell timer plane (see SampleTimerDelay), or nullptr to roll the burnout and regrowth
+    // dice every step. A cell only reads and writes its own timer, so it is updated in place.
+    uint32_t* timers = nullptr;
+};
+
+inline int GetMaterial(const WildfireCell& cellData)
+{
+    return cellData.material;
+}
+
+inline void SetMaterial(WildfireCell& cellData, int material)
+{
+    cellData.material = (uint8_t)material;
+}
+
+inline int GetState(const WildfireCell& cellData)
+{
+    return cellData.state;
+}
+
+inline void SetState(WildfireCell& cellData, int state)
+{
+    cellData.state = (uint8_t)state;
+}
+
+////////////////////////////////////////////////////////////////////
+/// TIMERS
+////////////////////////////////////////////////////////////////////
+
+// Per step probability that a burning cell burns out.
+constexpr float BURNOUT_PROBABILITY = 0.01f;
+
+// Timer of a cell with no pending transition.
+constexpr uint32_t WILDFIRE_TIMER_NEVER = 0xFFFFFFFFu;
+
+// Burnout and regrowth happen with a fixed probability per step, so the step they happen at is
+// geometrically distributed. Instead of a draw per step, the delay is drawn once when the cell
+// enters the state and stored in its timer; the transition fires on the step the counter reaches
+// it. This gives the number of steps until the first success (at least 1) from one uniform draw
+// in [0, 1), or WILDFIRE_TIMER_NEVER if the probability is zero.
+inline uint32_t SampleTimerDelay(float probability, float u)
+{
+    if (probability <= 0.0f)
+    {
+        return WILDFIRE_TIMER_NEVER;
+    }
+    if (probability >= 1.0f)
+    {
+        return 1;
+    }
+
+    const float delay = 1.0f + glm::floor(glm::log(1.0f - u) / glm::log(1.0f - probability));
+    return delay < 4294967040.0f ? (uint32_t)delay : WILDFIRE_TIMER_NEVER;
+}
+
+// step + delay, saturating at WILDFIRE_TIMER_NEVER.
+inline uint32_t AddTimerDelay(uint32_t step, uint32_t delay)
+{
+    return delay >= WILDFIRE_TIMER_NEVER - step ? WILDFIRE_TIMER_NEVER : step + delay;
+}
+
+// The timer of a cell which enters its state on this step: the first roll of the dice would
+// have been the next step's.
+inline uint32_t SampleTimer(uint64_t seed, uint32_t step, uint32_t cellIndex, float probability)
+{
+    return AddTimerDelay(step, SampleTimerDelay(probability, wildfireRandom(seed, step, cellIndex, RANDOM_DRAW_TIMER)));
+}
+
+// The probability of the timed transition of a cell in this state, or 0 if it has none.
+inline float GetTimerProbability(const WildfireParameters& parameters, const WildfireCell& cellData)
+{
+    const int cellState = GetState(cellData);
+    if (cellState == STATE_ON_FIRE)
+    {
+        return BURNOUT_PROBABILITY;
+    }
+    else if (cellState == STATE_DESTROYED)
+    {
+        return parameters.grassRegrowProbability;
+    }
+    else if (GetMaterial(cellData) == MATERIAL_GRASS)
+    {
+        return parameters.treeRegrowProbability;
+    }
+
+    return 0.0f;
+}
+
+// A fresh timer for a cell whose timer is unknown or was drawn with other probabilities. The
+// waiting time is memoryless, so the cell can be treated as if it had just entered its state
+// before this step: the transition may already fire on this step.
+inline uint32_t ResampleTimer(const WildfireParameters& parameters, uint32_t step, uint32_t cellIndex, const WildfireCell& cellData)
+{
+    const uint32_t delay = SampleTimerDelay(GetTimerProbability(parameters, cellData), wildfireRandom(parameters.seed, step, cellIndex, RANDOM_DRAW_TIMER_RESAMPLE));
+    return delay == WILDFIRE_TIMER_NEVER ? WILDFIRE_TIMER_NEVER : AddTimerDelay(step, delay - 1);
+}
+
+// The transition processCell makes when the timer of a cell is due on this step: burnout, or
+// regrowth. None of them looks at the neighbours. Returns false if the cell has nothing timed.
+inline bool ApplyDueTimer(const WildfireParameters& parameters, uint32_t step, uint32_t cellIndex, WildfireCell& cellData, uint32_t& timer)
+{
+    const int cellState = GetState(cellData);
+    if (cellState == STATE_ON_FIRE)
+    {
+        SetState(cellData, STATE_DESTROYED);
+        timer = SampleTimer(parameters.seed, step, cellIndex, parameters.grassRegrowProbability);
+    }
+    else if (cellState == STATE_DESTROYED)
+    {
+        SetState(cellData, STATE_NOT_ON_FIRE);
+        SetMaterial(cellData, MATERIAL_GRASS);
+        timer = SampleTimer(parameters.seed, step, cellIndex, parameters.treeRegrowProbability);
+    }
+    else if (GetMaterial(cellData) == MATERIAL_GRASS)
+    {
+        SetMaterial(cellData, MATERIAL_TREE_1);
+        timer = WILDFIRE_TIMER_NEVER;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+inline float CalculateTemperature(const WildfireParameters& parameters, uint32_t step)
+{
+    if (!parameters.bUseTemperature)
+    {
+        return 20.0f; // Default temperature if system is disabled
+    }
+
+    int hourOfDay = int(step % 24);
+    float average_temp = 20.0f;
+    float amplitude = 5.0f;
+
+    float temp = average_temp + amplitude * glm::sin(2.0f * 3.14159265f * float(hourOfDay) / 24.0f - 3.14159265f / 2.0f);
+
+    // Add some noise
+    temp += (wildfireRandom(parameters.seed, step, RANDOM_GLOBAL_CELL, 0, RANDOM_STREAM_GLOBAL) - 0.5f) * 2.0f;
+
+    return temp;
+}
+
+inline bool IsImpactedByMouse(const WildfireStepContext& context, glm::vec2 coord)
+{
+    if (context.bIsMouseDown)
+    {
+        glm::vec2 fireCenter = glm::vec2(context.gridSize) * context.mousePos;
+
+        if (glm::length(fireCenter - coord) < 10.0f)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline glm::vec2 GetWindDirection(const WildfireParameters& parameters)
+{
+    switch (parameters.windDirectionIndex)
+    {
+    case 1: return glm::vec2(1, 0);   // east
+    case 2: return glm::vec2(-1, 0);  // west
+    case 3: return glm::vec2(0, 1);   // north
+    case 4: return glm::vec2(0, -1);  // south
+    case 5: return glm::vec2(1, 1);   // northeast
+    case 6: return glm::vec2(-1, 1);  // northwest
+    case 7: return glm::vec2(1, -1);  // southeast
+    case 8: return glm::vec2(-1, -1); // southwest
+    case WIND_DIRECTION_ANGLE:
+    {
+        const float angle = glm::radians(parameters.windAngleDegrees);
+        return glm::vec2(glm::cos(angle), glm::sin(angle));
+    }
+    default: return glm::vec2(0, 0);
+    }
+}
+
+// The share of the spread probability contributed by one burning neighbour at neighborOffset
+// from the cell, when the wind blows along windDirection (non-zero).
+inline float GetNeighborSpreadProb(glm::vec2 windDirection, glm::ivec2 neighborOffset)
+{
+    // Compute the dot product to check alignment with the wind
+    float windInfluence = glm::max(0.0f, glm::dot(glm::normalize(-glm::vec2(neighborOffset)), windDirection));
+
+    // Increase probability based on wind influence
+    return (0.1f + 0.9f * windInfluence) / 8;
+}
+
+// Bit k of a neighbour mask is the k-th neighbour in this order (x outer, y inner, as the
+// shader always looped over them).
+constexpr int NUM_NEIGHBORS = 8;
+
+inline glm::ivec2 GetNeighborOffset(int neighbor)
+{
+    const int offsetIndex = neighbor < 4 ? neighbor : neighbor + 1;
+    return glm::ivec2(offsetIndex / 3 - 1, offsetIndex % 3 - 1);
+}
+
+// The inverse of GetNeighborOffset.
+inline int GetNeighbor(glm::ivec2 neighborOffset)
+{
+    const int offsetIndex = (neighborOffset.x + 1) * 3 + (neighborOffset.y + 1);
+    return offsetIndex < 4 ? offsetIndex : offsetIndex - 1;
+}
+
+// The edge neighbours (-x, -y, +y, +x) of the neighbour bit order.
+constexpr uint32_t VON_NEUMANN_NEIGHBOR_MASK = 0x5Au;
+
+// Nibble k of a packed slope factor q gives the multiplier 1 + q * SLOPE_MULTIPLIER_STEP for
+// fire arriving from neighbour k.
+constexpr float SLOPE_MULTIPLIER_STEP = 0.25f;
+constexpr uint32_t MAX_SLOPE_MULTIPLIER_LEVEL = 15;
+
+// The fire runs uphill from its lowest burning neighbour, so the strongest multiplier of the
+// burning neighbours scales the cell's spread probability.
+inline float GetSlopeMultiplier(uint32_t packedSlopeFactors, uint32_t burningNeighborMask)
+{
+    uint32_t level = 0;
+    for (int neighbor = 0; neighbor < NUM_NEIGHBORS; neighbor++)
+    {
+        if (burningNeighborMask & (1u << neighbor))
+        {
+            level = glm::max(level, (packedSlopeFactors >> (4 * neighbor)) & 0xFu);
+        }
+    }
+
+    return 1.0f + (float)level * SLOPE_MULTIPLIER_STEP;
+}
+
+// getNeighborState(x, y) must return the state of the cell at the given integer coordinate,
+// and STATE_NOT_ON_FIRE outside of the grid (which is what imageLoad returns out of bounds).
+template <typename NeighborStateFn>
+inline uint32_t GetBurningNeighborMask(glm::ivec2 coord, NeighborStateFn&& getNeighborState)
+{
+    uint32_t mask = 0;
+    int neighbor = 0;
+
+    for (int i = -1; i <= 1; i++)
+    {
+        for (int j = -1; j <= 1; j++)
+        {
+            if (i == 0 && j == 0) continue;
+
+            if (getNeighborState(coord.x + i, coord.y + j) == STATE_ON_FIRE)
+            {
+                mask |= 1u << neighbor;
+            }
+            neighbor++;
+        }
+    }
+
+    return mask;
+}
+
+// The spread probability of a cell whose burning neighbours are burningNeighborMask, under
+// the wind windDirection. Summed in neighbour order, so the table holds exactly what the
+// per-cell loop used to compute.
+inline float GetWindSpreadProb(glm::vec2 windDirection, uint32_t burningNeighborMask)
+{
+    float prob = 0.0f;
+    for (int neighbor = 0; neighbor < NUM_NEIGHBORS; neighbor++)
+    {
+        if (burningNeighborMask & (1u << neighbor))
+        {
+            prob += GetNeighborSpreadProb(windDirection, GetNeighborOffset(neighbor));
+        }
+    }
+
+    return prob;
+}
+
+inline float GetWindSpreadProb(const WildfireParameters& parameters, uint32_t burningNeighborMask)
+{
+    if (burningNeighborMask == 0)
+    {
+        return 0.0f;
+    }
+
+    if (parameters.windDirectionIndex == 0)
+    {
+        return 1.0f / 8 / 2;
+    }
+
+    return GetWindSpreadProb(GetWindDirection(parameters), burningNeighborMask);
+}
+
+inline float GetFlammableProbability(const WildfireParameters& parameters, int cellMaterial)
+{
+    if (cellMaterial == MATERIAL_GRASS)
+    {
+        return parameters.flammableProbabilityForGrass;
+    }
+    else if (cellMaterial == MATERIAL_WATER)
+    {
+        return parameters.flammableProbabilityForWater;
+    }
+    else if (cellMaterial == MATERIAL_BEDROCK)
+    {
+        return parameters.flammableProbabilityForBedrock;
+    }
+    else if (cellMaterial == MATERIAL_TREE_1 || cellMaterial == MATERIAL_TREE_2 || cellMaterial == MATERIAL_TREE_3)
+    {
+        return parameters.flammableProbabilityForTree;
+    }
+
+    return 0.0f;
+}
+
+inline void buildWildfireRuleTable(const WildfireParameters& parameters, WildfireRuleTable& outTable)
+{
+    for (uint32_t mask = 0; mask < 256; mask++)
+    {
+        const uint32_t spreadingMask = parameters.bUseVonNeumannNeighborhood ? mask & VON_NEUMANN_NEIGHBOR_MASK : mask;
+        outTable.spreadProbabilities[mask] = GetWindSpreadProb(parameters, spreadingMask);
+    }
+
+    for (int material = 0; material < MATERIAL_COUNT; material++)
+    {
+        outTable.flammableProbabilities[material] = GetFlammableProbability(parameters, material);
+    }
+}
+
+// Keeps the rule table of the last parameters and rebuilds it only when the wind, a
+// flammable probability or the neighbourhood changes.
+class WildfireRuleTableCache
+{
+public:
+    // Returns true if the table was rebuilt.
+    bool update(const WildfireParameters& parameters)
+    {
+        const bool bIsStale = !bIsBuilt
+            || parameters.windDirectionIndex != builtParameters.windDirectionIndex
+            || (parameters.windDirectionIndex == WIND_DIRECTION_ANGLE && parameters.windAngleDegrees != builtParameters.windAngleDegrees)
+            || parameters.flammableProbabilityForGrass != builtParameters.flammableProbabilityForGrass
+            || parameters.flammableProbabilityForWater != builtParameters.flammableProbabilityForWater
+            || parameters.flammableProbabilityForBedrock != builtParameters.flammableProbabilityForBedrock
+            || parameters.flammableProbabilityForTree != builtParameters.flammableProbabilityForTree
+            || parameters.bUseVonNeumannNeighborhood != builtParameters.bUseVonNeumannNeighborhood;
+
+        if (bIsStale)
+        {
+            buildWildfireRuleTable(parameters, table);
+            builtParameters = parameters;
+            bIsBuilt = true;
+        }
+
+        return bIsStale;
+    }
+
+    const WildfireRuleTable& get() const { return table; }
+
+private:
+    WildfireRuleTable table = {};
+    WildfireParameters builtParameters;
+    bool bIsBuilt = false;
+};
+
+inline float GetTableFlammableProbability(const WildfireRuleTable& ruleTable, int cellMaterial)
+{
+    return cellMaterial < MATERIAL_COUNT ? ruleTable.flammableProbabilities[cellMaterial] : 0.0f;
+}
+
+////////////////////////////////////////////////////////////////////
+/// RULE VARIANTS
+////////////////////////////////////////////////////////////////////
+
+// The rules which can be switched off for a whole step. processCell is instantiated once per
+// combination, so a disabled rule costs nothing in the cell loop instead of a branch per cell.
+// The global wind needs no variant: it is folded into the rule table.
+constexpr uint32_t WILDFIRE_RULE_TEMPERATURE = 1u << 0;
+constexpr uint32_t WILDFIRE_RULE_REGROWTH = 1u << 1;
+constexpr uint32_t WILDFIRE_RULE_VON_NEUMANN = 1u << 2;
+constexpr uint32_t WILDFIRE_RULE_WIND_FIELD = 1u << 3;
+constexpr uint32_t WILDFIRE_RULE_SLOPE = 1u << 4;
+constexpr uint32_t WILDFIRE_RULE_IGNITION = 1u << 5;
+constexpr uint32_t WILDFIRE_RULE_TIMERS = 1u << 6;
+constexpr uint32_t WILDFIRE_RULE_END = 1u << 7;
+constexpr uint32_t WILDFIRE_RULE_ALL = WILDFIRE_RULE_END - 1;
+
+// Tag passed to the kernels of dispatchWildfireRules.
+template <uint32_t Rules>
+using WildfireRuleVariant = std::integral_constant<uint32_t, Rules>;
+
+// The rules a step with these parameters and this context needs.
+inline uint32_t getWildfireRules(const WildfireParameters& parameters, const WildfireStepContext& context)
+{
+    uint32_t rules = 0;
+    rules |= parameters.bUseTemperature ? WILDFIRE_RULE_TEMPERATURE : 0u;
+    rules |= parameters.grassRegrowProbability > 0.0f || parameters.treeRegrowProbability > 0.0f ? WILDFIRE_RULE_REGROWTH : 0u;
+    rules |= parameters.bUseVonNeumannNeighborhood ? WILDFIRE_RULE_VON_NEUMANN : 0u;
+    rules |= context.windField != nullptr ? WILDFIRE_RULE_WIND_FIELD : 0u;
+    rules |= context.slopeFactors != nullptr ? WILDFIRE_RULE_SLOPE : 0u;
+    rules |= context.bIsMouseDown ? WILDFIRE_RULE_IGNITION : 0u;
+    rules |= context.timers != nullptr ? WILDFIRE_RULE_TIMERS : 0u;
+    return rules;
+}
+
+// Resolves one rule bit per level, so every combination of the supported rules is instantiated.
+// An unsupported rule resolves to the same type on both branches, so it adds no variants.
+template <uint32_t SupportedRules, uint32_t Rules, uint32_t Rule>
+struct WildfireRuleDispatcher
+{
+    template <typename KernelFn>
+    static void dispatch(uint32_t rules, KernelFn& kernel)
+    {
+        if (rules & Rule) {
+            WildfireRuleDispatcher<SupportedRules, Rules | (Rule & SupportedRules), (Rule << 1)>::dispatch(rules, kernel);
+        }
+        else {
+            WildfireRuleDispatcher<SupportedRules, Rules, (Rule << 1)>::dispatch(rules, kernel);
+        }
+    }
+};
+
+template <uint32_t SupportedRules, uint32_t Rules>
+struct WildfireRuleDispatcher<SupportedRules, Rules, WILDFIRE_RULE_END>
+{
+    template <typename KernelFn>
+    static void dispatch(uint32_t, KernelFn& kernel)
+    {
+        kernel(WildfireRuleVariant<Rules>());
+    }
+};
+
+// Call kernel(WildfireRuleVariant<rules>()) with the rules as a compile-time constant. Call it
+// around the cell loop of a step, not inside it. Rules outside SupportedRules are dropped, for
+// engines which never enable them.
+template <uint32_t SupportedRules = WILDFIRE_RULE_ALL, typename KernelFn>
+inline void dispatchWildfireRules(uint32_t rules, KernelFn&& kernel)
+{
+    WildfireRuleDispatcher<SupportedRules, 0u, 1u>::dispatch(rules, kernel);
+}
+
+// Process a single cell. Rules must include every rule of getWildfireRules() for the step.
+template <uint32_t Rules, typename NeighborStateFn>
+inline void processCell(const WildfireParameters& parameters, const WildfireStepContext& context, glm::ivec2 icoord, WildfireCell& cellData, NeighborStateFn&& getNeighborState)
+{
+    const glm::vec2 coord = glm::vec2(icoord);
+    const uint32_t cellIndex = (uint32_t)icoord.y * (uint32_t)context.gridSize.x + (uint32_t)icoord.x;
+
+    int cellMaterial = GetMaterial(cellData);
+    int cellState = GetState(cellData);
+
+    if (cellState == STATE_NOT_ON_FIRE)
+    {
+        // Draws 0-3 share one Philox block.
+        const PhiloxBlock randomBlock = wildfireRandomBlock(parameters.seed, context.step, cellIndex, 0);
+
+        if ((Rules & WILDFIRE_RULE_REGROWTH) && cellMaterial == MATERIAL_GRASS)
+        {
+            bool bRegrowsTree;
+            if (Rules & WILDFIRE_RULE_TIMERS)
+            {
+                bRegrowsTree = context.step >= context.timers[cellIndex];
+            }
+            else
+            {
+                float regrowTreeProb = parameters.treeRegrowProbability;
+                float newTreeProb = wildfireRandomFromBlock(randomBlock, RANDOM_DRAW_TREE_REGROW);
+                bRegrowsTree = regrowTreeProb > newTreeProb;
+            }
+
+            if (bRegrowsTree)
+            {
+                SetMaterial(cellData, MATERIAL_TREE_1);
+                if (Rules & WILDFIRE_RULE_TIMERS)
+                {
+                    context.timers[cellIndex] = WILDFIRE_TIMER_NEVER;
+                }
+                return;
+            }
+        }
+
+        uint32_t burningNeighborMask = GetBurningNeighborMask(icoord, getNeighborState);
+
+        if (Rules & WILDFIRE_RULE_VON_NEUMANN)
+        {
+            burningNeighborMask &= VON_NEUMANN_NEIGHBOR_MASK;
+        }
+
+        // The local wind only matters next to the fire, so the field is sampled on the front alone.
+        float windSpreadThreshold = (Rules & WILDFIRE_RULE_WIND_FIELD) && burningNeighborMask != 0
+            ? GetWindSpreadProb(context.windField->sample(icoord, context.gridSize), burningNeighborMask)
+            : context.ruleTable->spreadProbabilities[burningNeighborMask];
+
+        if ((Rules & WILDFIRE_RULE_SLOPE) && burningNeighborMask != 0)
+        {
+            windSpreadThreshold *= GetSlopeMultiplier(context.slopeFactors[cellIndex], burningNeighborMask);
+        }
+
+        float windSpreadProb = wildfireRandomFromBlock(randomBlock, RANDOM_DRAW_WIND_SPREAD);
+
+        float fireCatchProb = wildfireRandomFromBlock(randomBlock, RANDOM_DRAW_FIRE_CATCH);
+
+        bool bCatchesFire = windSpreadThreshold > windSpreadProb || parameters.fireProbability > fireCatchProb;
+        if (Rules & WILDFIRE_RULE_IGNITION)
+        {
+            bCatchesFire = bCatchesFire || IsImpactedByMouse(context, coord);
+        }
+
+        if (bCatchesFire)
+        {
+            float flammableProb = GetTableFlammableProbability(*context.ruleTable, cellMaterial);
+
+            float randomProb = wildfireRandomFromBlock(randomBlock, RANDOM_DRAW_FLAMMABLE);
+
+            bool isHot = (Rules & WILDFIRE_RULE_TEMPERATURE) && context.temperature > 25.0f;
+            if (isHot)
+            {
+                randomProb *= 2;
+            }
+
+            if (flammableProb > randomProb)
+            {
+                SetState(cellData, STATE_ON_FIRE);
+                if (Rules & WILDFIRE_RULE_TIMERS)
+                {
+                    context.timers[cellIndex] = SampleTimer(parameters.seed, context.step, cellIndex, BURNOUT_PROBABILITY);
+                }
+            }
+        }
+    }
+    else if (cellState == STATE_ON_FIRE)
+    {
+        if (Rules & WILDFIRE_RULE_TIMERS)
+        {
+            if (context.step >= context.timers[cellIndex])
+            {
+                SetState(cellData, STATE_DESTROYED);
+                context.timers[cellIndex] = SampleTimer(parameters.seed, context.step, cellIndex, parameters.grassRegrowProbability);
+            }
+        }
+        else
+        {
+            float randomProb = wildfireRandom(parameters.seed, context.step, cellIndex, RANDOM_DRAW_BURNOUT);
+            if (randomProb < BURNOUT_PROBABILITY)
+            {
+                SetState(cellData, STATE_DESTROYED);
+            }
+        }
+    }
+    else if ((Rules & WILDFIRE_RULE_REGROWTH) && cellState == STATE_DESTROYED)
+    {
+        if (Rules & WILDFIRE_RULE_TIMERS)
+        {
+            if (context.step >= context.timers[cellIndex])
+            {
+                SetState(cellData, STATE_NOT_ON_FIRE);
+                SetMaterial(cellData, MATERIAL_GRASS);
+                context.timers[cellIndex] = SampleTimer(parameters.seed, context.step, cellIndex, parameters.treeRegrowProbability);
+            }
+        }
+        else
+        {
+            float regrowGrassProb = parameters.grassRegrowProbability;
+            float newGrassProb = wildfireRandom(parameters.seed, context.step, cellIndex, RANDOM_DRAW_GRASS_REGROW);
+            if (regrowGrassProb > newGrassProb)
+            {
+                SetState(cellData, STATE_NOT_ON_FIRE);
+                SetMaterial(cellData, MATERIAL_GRASS);
+            }
+        }
+    }
+}
+
+// For a cell with no burning neighbour outside the mouse radius and no due timer, the only thing
+// processCell can still do is spontaneous ignition. This is the per-step probability that it is
+// attempted (the fire-catch draw hits). Regrowth is left to the timers.
+inline float GetIdleEventProbability(const WildfireParameters& parameters, const WildfireCell& cellData)
+{
+    if (GetState(cellData) == STATE_NOT_ON_FIRE)
+    {
+        return glm::clamp(parameters.fireProbability, 0.0f, 1.0f);
+    }
+
+    return 0.0f;
+}
+
+// Upper bound of GetIdleEventProbability over every cell.
+inline float GetIdleEventProbabilityBound(const WildfireParameters& parameters)
+{
+    return glm::clamp(parameters.fireProbability, 0.0f, 1.0f);
+}
+
+// Apply an idle event which is known to happen. flammableRandom must be uniform in [0, 1). This
+// gives the cell the same outcome distribution processCell has, conditioned on the event.
+inline void processIdleEvent(const WildfireParameters& parameters, const WildfireStepContext& context, uint32_t cellIndex, WildfireCell& cellData, float flammableRandom)
+{
+    if (GetState(cellData) != STATE_NOT_ON_FIRE)
+    {
+        return;
+    }
+
+    float randomProb = flammableRandom;
+    if (context.temperature > 25.0f)
+    {
+        randomProb *= 2;
+    }
+
+    if (GetTableFlammableProbability(*context.ruleTable, GetMaterial(cellData)) > randomProb)
+    {
+        SetState(cellData, STATE_ON_FIRE);
+        context.timers[cellIndex] = SampleTimer(parameters.seed, context.step, cellIndex, BURNOUT_PROBABILITY);
+    }
+}
+
+#endif
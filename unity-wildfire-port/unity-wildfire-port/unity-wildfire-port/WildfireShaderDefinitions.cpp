@@ -0,0 +1,85 @@
+#include "WildfireShaderDefinitions.h"
+
+#include <sstream>
+
+static void addDefine(std::string& defines, const char* name, int value)
+{
+    defines += "#define " + std::string(name) + " " + std::to_string(value) + "\n";
+}
+
+static void addUIntDefine(std::string& defines, const char* name, uint32_t value)
+{
+    defines += "#define " + std::string(name) + " " + std::to_string(value) + "u\n";
+}
+
+static void addFloatDefine(std::string& defines, const char* name, float value)
+{
+    std::ostringstream stream;
+    stream.precision(9);
+    stream << value;
+
+    // Without a point or an exponent GLSL would read an int.
+    std::string literal = stream.str();
+    if (literal.find_first_of(".e") == std::string::npos) {
+        literal += ".0";
+    }
+
+    defines += "#define " + std::string(name) + " " + literal + "\n";
+}
+
+std::string getWildfireShaderDefinitions()
+{
+    std::string defines;
+
+    addDefine(defines, "MATERIAL_GRASS", MATERIAL_GRASS);
+    addDefine(defines, "MATERIAL_WATER", MATERIAL_WATER);
+    addDefine(defines, "MATERIAL_BEDROCK", MATERIAL_BEDROCK);
+    addDefine(defines, "MATERIAL_TREE_1", MATERIAL_TREE_1);
+    addDefine(defines, "MATERIAL_TREE_2", MATERIAL_TREE_2);
+    addDefine(defines, "MATERIAL_TREE_3", MATERIAL_TREE_3);
+    addDefine(defines, "MATERIAL_COUNT", MATERIAL_COUNT);
+
+    addDefine(defines, "STATE_NOT_ON_FIRE", STATE_NOT_ON_FIRE);
+    addDefine(defines, "STATE_ON_FIRE", STATE_ON_FIRE);
+    addDefine(defines, "STATE_DESTROYED", STATE_DESTROYED);
+
+    addUIntDefine(defines, "RANDOM_DRAW_TREE_REGROW", RANDOM_DRAW_TREE_REGROW);
+    addUIntDefine(defines, "RANDOM_DRAW_WIND_SPREAD", RANDOM_DRAW_WIND_SPREAD);
+    addUIntDefine(defines, "RANDOM_DRAW_FIRE_CATCH", RANDOM_DRAW_FIRE_CATCH);
+    addUIntDefine(defines, "RANDOM_DRAW_FLAMMABLE", RANDOM_DRAW_FLAMMABLE);
+    addUIntDefine(defines, "RANDOM_DRAW_TIMER", RANDOM_DRAW_TIMER);
+    addUIntDefine(defines, "RANDOM_DRAW_TIMER_RESAMPLE", RANDOM_DRAW_TIMER_RESAMPLE);
+    addUIntDefine(defines, "RANDOM_STREAM_CELL", RANDOM_STREAM_CELL);
+    addUIntDefine(defines, "RANDOM_STREAM_GLOBAL", RANDOM_STREAM_GLOBAL);
+    addUIntDefine(defines, "RANDOM_GLOBAL_CELL", RANDOM_GLOBAL_CELL);
+
+    addFloatDefine(defines, "SLOPE_MULTIPLIER_STEP", SLOPE_MULTIPLIER_STEP);
+    addUIntDefine(defines, "VON_NEUMANN_NEIGHBOR_MASK", VON_NEUMANN_NEIGHBOR_MASK);
+
+    addFloatDefine(defines, "BURNOUT_PROBABILITY", BURNOUT_PROBABILITY);
+    addUIntDefine(defines, "WILDFIRE_TIMER_NEVER", WILDFIRE_TIMER_NEVER);
+
+    return defines;
+}
+
+std::string getWildfireRuleShaderDefines(uint32_t rules)
+{
+    std::string defines;
+    addDefine(defines, "USE_TEMP", (rules & WILDFIRE_RULE_TEMPERATURE) != 0);
+    addDefine(defines, "USE_REGROWTH", (rules & WILDFIRE_RULE_REGROWTH) != 0);
+    addDefine(defines, "USE_VON_NEUMANN", (rules & WILDFIRE_RULE_VON_NEUMANN) != 0);
+    addDefine(defines, "USE_WIND_FIELD", (rules & WILDFIRE_RULE_WIND_FIELD) != 0);
+    addDefine(defines, "USE_SLOPE", (rules & WILDFIRE_RULE_SLOPE) != 0);
+    return defines;
+}
+
+uint32_t getWildfireShaderRules(const WildfireParameters& parameters, bool bUseWindField)
+{
+    uint32_t rules = 0;
+    rules |= parameters.bUseTemperature ? WILDFIRE_RULE_TEMPERATURE : 0u;
+    rules |= parameters.grassRegrowProbability > 0.0f || parameters.treeRegrowProbability > 0.0f ? WILDFIRE_RULE_REGROWTH : 0u;
+    rules |= parameters.bUseVonNeumannNeighborhood ? WILDFIRE_RULE_VON_NEUMANN : 0u;
+    rules |= bUseWindField ? WILDFIRE_RULE_WIND_FIELD : 0u;
+    rules |= parameters.bUseSlope ? WILDFIRE_RULE_SLOPE : 0u;
+    return rules;
+}
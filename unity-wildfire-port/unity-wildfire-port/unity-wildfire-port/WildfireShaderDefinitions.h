@@ -0,0 +1,34 @@
+#ifndef WILDFIRE_SHADER_DEFINITIONS_H
+#define WILDFIRE_SHADER_DEFINITIONS_H
+
+#include "WildfireRules.h"
+
+#include <cstdint>
+#include <string>
+
+// ----------------------------------------------------------------------------
+//
+// The GLSL side of the shared definitions. Materials, states, random draw indices and the
+// rule constants are generated from their C++ definitions and injected after the #version
+// line of every wildfire shader, so the shaders cannot drift from WildfireDefinitions.h.
+//
+// The compute shader is also compiled in permutations: the rules of WILDFIRE_SHADER_RULES
+// become #defines instead of uniforms, so the GPU compiler strips the branches of rules
+// which are off.
+//
+// ----------------------------------------------------------------------------
+
+// The rules the compute shader is specialized on. Mouse ignition stays a uniform: a click
+// must not wait for a compile.
+constexpr uint32_t WILDFIRE_SHADER_RULES = WILDFIRE_RULE_TEMPERATURE | WILDFIRE_RULE_REGROWTH | WILDFIRE_RULE_VON_NEUMANN | WILDFIRE_RULE_WIND_FIELD | WILDFIRE_RULE_SLOPE;
+
+// "#define MATERIAL_GRASS 0\n..." for every shared definition.
+std::string getWildfireShaderDefinitions();
+
+// The USE_* defines of a compute shader permutation. Rules outside WILDFIRE_SHADER_RULES are ignored.
+std::string getWildfireRuleShaderDefines(uint32_t rules);
+
+// The WILDFIRE_SHADER_RULES bits a GPU step with these parameters needs.
+uint32_t getWildfireShaderRules(const WildfireParameters& parameters, bool bUseWindField);
+
+#endif
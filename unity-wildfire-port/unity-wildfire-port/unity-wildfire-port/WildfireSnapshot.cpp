@@ -0,0 +1,326 @@
+#include "WildfireSnapshot.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Shorter repeats are cheaper to store as literals.
+static constexpr size_t MIN_SNAPSHOT_RUN_LENGTH = 3;
+
+void writeWildfireVarint(uint64_t value, std::vector<uint8_t>& outBytes)
+{
+    while (value >= 0x80) {
+        outBytes.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    outBytes.push_back((uint8_t)value);
+}
+
+bool readWildfireVarint(const uint8_t*& bytes, const uint8_t* end, uint64_t& outValue)
+{
+    outValue = 0;
+    for (int shift = 0; shift < 64 && bytes < end; shift += 7) {
+        const uint8_t byte = *bytes++;
+        outValue |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+/// CELL PLANES
+////////////////////////////////////////////////////////////////////
+
+// Each packet is a varint (length << 1 | isRun) followed by the one repeated byte of a run,
+// or by the length bytes of a literal.
+void encodeWildfireCellPlane(const WildfireCell* cells, size_t cellCount, size_t planeOffset, std::vector<uint8_t>& outBytes)
+{
+    const uint8_t* plane = (const uint8_t*)cells + planeOffset;
+    auto getByte = [&](size_t cellIndex) { return plane[cellIndex * sizeof(WildfireCell)]; };
+
+    auto writeLiteral = [&](size_t start, size_t end) {
+        if (end > start) {
+            writeWildfireVarint((uint64_t)(end - start) << 1, outBytes);
+
+            const size_t literalOffset = outBytes.size();
+            outBytes.resize(literalOffset + (end - start));
+            for (size_t cellIndex = start; cellIndex < end; cellIndex++) {
+                outBytes[literalOffset + (cellIndex - start)] = getByte(cellIndex);
+            }
+        }
+    };
+
+    size_t literalStart = 0;
+    size_t cellIndex = 0;
+    while (cellIndex < cellCount) {
+        const uint8_t value = getByte(cellIndex);
+
+        size_t runEnd = cellIndex + 1;
+        while (runEnd < cellCount && getByte(runEnd) == value) {
+            ++runEnd;
+        }
+
+        if (runEnd - cellIndex >= MIN_SNAPSHOT_RUN_LENGTH) {
+            writeLiteral(literalStart, cellIndex);
+            writeWildfireVarint((uint64_t)(runEnd - cellIndex) << 1 | 1, outBytes);
+            outBytes.push_back(value);
+            literalStart = runEnd;
+        }
+
+        cellIndex = runEnd;
+    }
+
+    writeLiteral(literalStart, cellCount);
+}
+
+bool decodeWildfireCellPlane(const uint8_t* bytes, size_t byteCount, WildfireCell* cells, size_t cellCount, size_t planeOffset)
+{
+    uint8_t* plane = (uint8_t*)cells + planeOffset;
+    const uint8_t* end = bytes + byteCount;
+
+    size_t cellIndex = 0;
+    while (bytes < end) {
+        uint64_t packet;
+        if (!readWildfireVarint(bytes, end, packet)) {
+            return false;
+        }
+
+        const uint64_t length = packet >> 1;
+        const bool bIsRun = (packet & 1) != 0;
+        if (length > cellCount - cellIndex || (uint64_t)(end - bytes) < (bIsRun ? 1 : length)) {
+            return false;
+        }
+
+        for (uint64_t i = 0; i < length; i++) {
+            plane[(cellIndex + i) * sizeof(WildfireCell)] = bIsRun ? bytes[0] : bytes[i];
+        }
+
+        bytes += bIsRun ? 1 : length;
+        cellIndex += length;
+    }
+
+    return cellIndex == cellCount;
+}
+
+////////////////////////////////////////////////////////////////////
+/// HEIGHT PLANE
+////////////////////////////////////////////////////////////////////
+
+// The terrain is smooth, so the difference to the previous height (zigzag varint) is mostly one byte.
+void encodeWildfireHeights(const uint16_t* heights, size_t cellCount, std::vector<uint8_t>& outBytes)
+{
+    outBytes.reserve(outBytes.size() + cellCount + cellCount / 4);
+
+    int previousHeight = 0;
+    for (size_t cellIndex = 0; cellIndex < cellCount; cellIndex++) {
+        const int delta = (int)heights[cellIndex] - previousHeight;
+        writeWildfireVarint(delta >= 0 ? (uint64_t)delta << 1 : ((uint64_t)(-delta) << 1) - 1, outBytes);
+        previousHeight = heights[cellIndex];
+    }
+}
+
+bool decodeWildfireHeights(const uint8_t* bytes, size_t byteCount, uint16_t* heights, size_t cellCount)
+{
+    const uint8_t* end = bytes + byteCount;
+
+    int previousHeight = 0;
+    for (size_t cellIndex = 0; cellIndex < cellCount; cellIndex++) {
+        uint64_t zigzag;
+        if (!readWildfireVarint(bytes, end, zigzag)) {
+            return false;
+        }
+
+        const int delta = (zigzag & 1) ? -(int)((zigzag + 1) >> 1) : (int)(zigzag >> 1);
+        heights[cellIndex] = (uint16_t)(previousHeight + delta);
+        previousHeight = heights[cellIndex];
+    }
+
+    return bytes == end;
+}
+
+////////////////////////////////////////////////////////////////////
+/// TIMER PLANE
+////////////////////////////////////////////////////////////////////
+
+// Runs of (length, value) varints. A value is 0 for WILDFIRE_TIMER_NEVER, otherwise the zigzag of
+// timer - stepCount plus one: pending timers lie a few hundred steps ahead, so most take two bytes.
+static uint64_t encodeWildfireTimer(uint32_t timer, uint32_t stepCount)
+{
+    if (timer == WILDFIRE_TIMER_NEVER) {
+        return 0;
+    }
+
+    const int64_t delta = (int64_t)timer - stepCount;
+    return (delta >= 0 ? (uint64_t)delta << 1 : ((uint64_t)(-delta) << 1) - 1) + 1;
+}
+
+static uint32_t decodeWildfireTimer(uint64_t value, uint32_t stepCount)
+{
+    if (value == 0) {
+        return WILDFIRE_TIMER_NEVER;
+    }
+
+    const uint64_t zigzag = value - 1;
+    const int64_t delta = (zigzag & 1) ? -(int64_t)((zigzag + 1) >> 1) : (int64_t)(zigzag >> 1);
+    return (uint32_t)((int64_t)stepCount + delta);
+}
+
+void encodeWildfireTimers(const uint32_t* timers, size_t cellCount, uint32_t stepCount, std::vector<uint8_t>& outBytes)
+{
+    size_t cellIndex = 0;
+    while (cellIndex < cellCount) {
+        size_t runEnd = cellIndex + 1;
+        while (runEnd < cellCount && timers[runEnd] == timers[cellIndex]) {
+            ++runEnd;
+        }
+
+        writeWildfireVarint(runEnd - cellIndex, outBytes);
+        writeWildfireVarint(encodeWildfireTimer(timers[cellIndex], stepCount), outBytes);
+        cellIndex = runEnd;
+    }
+}
+
+bool decodeWildfireTimers(const uint8_t* bytes, size_t byteCount, uint32_t* timers, size_t cellCount, uint32_t stepCount)
+{
+    const uint8_t* end = bytes + byteCount;
+
+    size_t cellIndex = 0;
+    while (bytes < end) {
+        uint64_t length;
+        uint64_t value;
+        if (!readWildfireVarint(bytes, end, length) || !readWildfireVarint(bytes, end, value) || length > cellCount - cellIndex) {
+            return false;
+        }
+
+        std::fill(timers + cellIndex, timers + cellIndex + length, decodeWildfireTimer(value, stepCount));
+        cellIndex += length;
+    }
+
+    return cellIndex == cellCount;
+}
+
+////////////////////////////////////////////////////////////////////
+/// FILES
+////////////////////////////////////////////////////////////////////
+
+bool saveWildfireSnapshot(const char* path, int width, int height, uint32_t stepCount, uint64_t seed, const WildfireCell* cells, const uint16_t* heights, const uint32_t* timers)
+{
+    const size_t cellCount = (size_t)width * height;
+
+    // One buffer for every plane, so the file is written with a single call.
+    std::vector<uint8_t> bytes;
+
+    encodeWildfireCellPlane(cells, cellCount, offsetof(WildfireCell, material), bytes);
+    const size_t materialByteCount = bytes.size();
+
+    encodeWildfireCellPlane(cells, cellCount, offsetof(WildfireCell, state), bytes);
+    const size_t stateByteCount = bytes.size() - materialByteCount;
+
+    if (heights != nullptr) {
+        encodeWildfireHeights(heights, cellCount, bytes);
+    }
+    const size_t heightByteCount = bytes.size() - materialByteCount - stateByteCount;
+
+    if (timers != nullptr) {
+        encodeWildfireTimers(timers, cellCount, stepCount, bytes);
+    }
+
+    WildfireSnapshotHeader header = {};
+    header.magic = WILDFIRE_SNAPSHOT_MAGIC;
+    header.version = WILDFIRE_SNAPSHOT_VERSION;
+    header.width = width;
+    header.height = height;
+    header.stepCount = stepCount;
+    header.flags = (heights != nullptr ? SNAPSHOT_HAS_HEIGHTS : 0) | (timers != nullptr ? SNAPSHOT_HAS_TIMERS : 0);
+    header.seed = seed;
+    header.materialByteCount = materialByteCount;
+    header.stateByteCount = stateByteCount;
+    header.heightByteCount = heightByteCount;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+
+    if (!file) {
+        std::cerr << "Failed to write snapshot: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool loadWildfireSnapshot(const char* path, WildfireSnapshot& outSnapshot)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open snapshot: " << path << std::endl;
+        return false;
+    }
+
+    const size_t fileSize = (size_t)file.tellg();
+    file.seekg(0);
+
+    WildfireSnapshotHeader header = {};
+    std::vector<uint8_t> bytes(fileSize > sizeof(header) ? fileSize - sizeof(header) : 0);
+    file.read((char*)&header, sizeof(header));
+    file.read((char*)bytes.data(), (std::streamsize)bytes.size());
+
+    const bool bIsHeaderValid = file
+        && header.magic == WILDFIRE_SNAPSHOT_MAGIC
+        && header.version == WILDFIRE_SNAPSHOT_VERSION
+        && header.width > 0 && header.height > 0
+        && header.materialByteCount + header.stateByteCount + header.heightByteCount <= bytes.size()
+        && ((header.flags & SNAPSHOT_HAS_TIMERS) != 0 || header.materialByteCount + header.stateByteCount + header.heightByteCount == bytes.size())
+        && ((header.flags & SNAPSHOT_HAS_HEIGHTS) != 0 || header.heightByteCount == 0);
+
+    if (!bIsHeaderValid) {
+        std::cerr << "Not a valid snapshot: " << path << std::endl;
+        return false;
+    }
+
+    const size_t cellCount = (size_t)header.width * header.height;
+
+    outSnapshot.width = header.width;
+    outSnapshot.height = header.height;
+    outSnapshot.stepCount = header.stepCount;
+    outSnapshot.seed = header.seed;
+    outSnapshot.cells.resize(cellCount);
+    outSnapshot.heights.resize((header.flags & SNAPSHOT_HAS_HEIGHTS) != 0 ? cellCount : 0);
+    outSnapshot.timers.resize((header.flags & SNAPSHOT_HAS_TIMERS) != 0 ? cellCount : 0);
+
+    const uint8_t* materialBytes = bytes.data();
+    const uint8_t* stateBytes = materialBytes + header.materialByteCount;
+    const uint8_t* heightBytes = stateBytes + header.stateByteCount;
+    const uint8_t* timerBytes = heightBytes + header.heightByteCount;
+
+    const bool bIsDataValid = decodeWildfireCellPlane(materialBytes, (size_t)header.materialByteCount, outSnapshot.cells.data(), cellCount, offsetof(WildfireCell, material))
+        && decodeWildfireCellPlane(stateBytes, (size_t)header.stateByteCount, outSnapshot.cells.data(), cellCount, offsetof(WildfireCell, state))
+        && (outSnapshot.heights.empty() || decodeWildfireHeights(heightBytes, (size_t)header.heightByteCount, outSnapshot.heights.data(), cellCount))
+        && (outSnapshot.timers.empty() || decodeWildfireTimers(timerBytes, (size_t)(bytes.data() + bytes.size() - timerBytes), outSnapshot.timers.data(), cellCount, header.stepCount));
+
+    if (!bIsDataValid) {
+        std::cerr << "Corrupt snapshot: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool getWildfireSnapshotLandscape(const WildfireSnapshot& snapshot, WildfireLandscape& outLandscape)
+{
+    if (snapshot.heights.empty()) {
+        return false;
+    }
+
+    outLandscape.width = snapshot.width;
+    outLandscape.height = snapshot.height;
+    outLandscape.heights = snapshot.heights;
+    outLandscape.materials.resize(snapshot.cells.size());
+    for (size_t cellIndex = 0; cellIndex < snapshot.cells.size(); cellIndex++) {
+        outLandscape.materials[cellIndex] = snapshot.cells[cellIndex].material;
+    }
+
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef WILDFIRE_SNAPSHOT_H
+#define WILDFIRE_SNAPSHOT_H
+
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Compressed checkpoint of a simulation, so a run can be stopped and resumed later (with the
+// same random numbers) or handed to another machine.
+//
+// The material and state planes are split out of the GL_RG8UI cells and run-length encoded
+// separately: states are almost all STATE_NOT_ON_FIRE and materials come in large patches, so
+// both shrink to a small fraction of the 2 bytes per cell. The static height plane is optional
+// and delta encoded, so a series of snapshots of one scenario only needs to carry it once.
+// The burnout and regrowth timers are optional too; without them the restored engine redraws
+// them, which keeps the outcome distribution but not the exact run.
+//
+// Layout (little endian):
+//   WildfireSnapshotHeader
+//   material plane runs   (materialByteCount bytes)
+//   state plane runs      (stateByteCount bytes)
+//   height plane deltas   (heightByteCount bytes, 0 without SNAPSHOT_HAS_HEIGHTS)
+//   timer plane runs      (the rest of the file, only with SNAPSHOT_HAS_TIMERS)
+//
+// ----------------------------------------------------------------------------
+
+// The snapshot carries the static height plane.
+constexpr uint32_t SNAPSHOT_HAS_HEIGHTS = 1u << 0;
+
+// The snapshot carries the burnout and regrowth timers (see SampleTimer in WildfireRules.h).
+constexpr uint32_t SNAPSHOT_HAS_TIMERS = 1u << 1;
+
+struct WildfireSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+
+    // Number of steps simulated and the seed, which together key the random numbers of the next step.
+    uint32_t stepCount;
+    uint32_t flags;
+    uint64_t seed;
+
+    uint64_t materialByteCount;
+    uint64_t stateByteCount;
+    uint64_t heightByteCount;
+};
+
+static_assert(sizeof(WildfireSnapshotHeader) == 56, "The snapshot header layout must not change");
+
+constexpr uint32_t WILDFIRE_SNAPSHOT_MAGIC = 0x504E5357; // "WSNP"
+constexpr uint32_t WILDFIRE_SNAPSHOT_VERSION = 1;
+
+// A decoded snapshot. heights and timers are empty if the snapshot did not carry them.
+struct WildfireSnapshot
+{
+    int width = 0;
+    int height = 0;
+    uint32_t stepCount = 0;
+    uint64_t seed = 0;
+
+    std::vector<WildfireCell> cells;
+    std::vector<uint16_t> heights;
+    std::vector<uint32_t> timers;
+};
+
+// LEB128 varints, shared with the other compact formats (see WildfireTimeline.h).
+void writeWildfireVarint(uint64_t value, std::vector<uint8_t>& outBytes);
+bool readWildfireVarint(const uint8_t*& bytes, const uint8_t* end, uint64_t& outValue);
+
+// Run-length encode one byte plane of the cells (offsetof material or state), appending to outBytes.
+void encodeWildfireCellPlane(const WildfireCell* cells, size_t cellCount, size_t planeOffset, std::vector<uint8_t>& outBytes);
+
+// Decode a plane written by encodeWildfireCellPlane into the cells. Returns false if the data is malformed.
+bool decodeWildfireCellPlane(const uint8_t* bytes, size_t byteCount, WildfireCell* cells, size_t cellCount, size_t planeOffset);
+
+// Delta encode the height plane, appending to outBytes.
+void encodeWildfireHeights(const uint16_t* heights, size_t cellCount, std::vector<uint8_t>& outBytes);
+bool decodeWildfireHeights(const uint8_t* bytes, size_t byteCount, uint16_t* heights, size_t cellCount);
+
+// Run-length encode the timers relative to stepCount, appending to outBytes.
+void encodeWildfireTimers(const uint32_t* timers, size_t cellCount, uint32_t stepCount, std::vector<uint8_t>& outBytes);
+bool decodeWildfireTimers(const uint8_t* bytes, size_t byteCount, uint32_t* timers, size_t cellCount, uint32_t stepCount);
+
+// Write a snapshot of width x height cells (e.g. straight out of a mapped pixel buffer). heights
+// and timers may be null.
+bool saveWildfireSnapshot(const char* path, int width, int height, uint32_t stepCount, uint64_t seed, const WildfireCell* cells, const uint16_t* heights, const uint32_t* timers);
+
+bool loadWildfireSnapshot(const char* path, WildfireSnapshot& outSnapshot);
+
+// The static inputs stored in a snapshot, to rebuild an engine without the landscape images.
+// Returns false if the snapshot has no height plane.
+bool getWildfireSnapshotLandscape(const WildfireSnapshot& snapshot, WildfireLandscape& outLandscape);
+
+#endif
@@ -0,0 +1,154 @@
+#include "WildfireStats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+// Rows per parallel job. Large enough that the partial sums cost nothing to merge.
+static constexpr int STATS_BAND_ROW_COUNT = 64;
+
+static const char* const MATERIAL_NAMES[MATERIAL_COUNT] = { "grass", "water", "bedrock", "tree_1", "tree_2", "tree_3" };
+
+void WildfireBurnedArea::reset(const WildfireCell* cells, size_t cellCount)
+{
+    std::fill(std::begin(cellCounts), std::end(cellCounts), 0u);
+
+    for (size_t index = 0; index < cellCount; index++) {
+        if (cells[index].state != STATE_NOT_ON_FIRE) {
+            cellCounts[std::min<int>(cells[index].material, MATERIAL_COUNT - 1)]++;
+        }
+    }
+}
+
+void WildfireBurnedArea::add(const uint32_t* ignitedCounts)
+{
+    for (int material = 0; material < MATERIAL_COUNT; material++) {
+        cellCounts[material] += ignitedCounts[material];
+    }
+}
+
+WildfireStats makeWildfireStats(uint32_t stepCount, const uint32_t* counters, const WildfireBurnedArea& burnedArea)
+{
+    WildfireStats stats;
+    stats.stepCount = stepCount;
+    stats.burningCellCount = counters[0];
+    stats.perimeterEdgeCount = counters[1];
+    for (int material = 0; material < MATERIAL_COUNT; material++) {
+        stats.burnedCellCounts[material] = burnedArea.cellCounts[material];
+    }
+    return stats;
+}
+
+// Same counting as AccumulateStats() in the compute shader.
+static void accumulateBand(const WildfireCell* cells, int width, int height, int firstRow, int endRow, uint32_t* counters)
+{
+    for (int y = firstRow; y < endRow; y++) {
+        const WildfireCell* row = cells + (size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            const WildfireCell& cell = row[x];
+            if (cell.state != STATE_ON_FIRE) {
+                continue;
+            }
+
+            counters[0]++;
+
+            auto isUnburnt = [](const WildfireCell& neighbor) {
+                return neighbor.state == STATE_NOT_ON_FIRE && neighbor.material != MATERIAL_WATER;
+            };
+
+            counters[1] += (x > 0 && isUnburnt(row[x - 1]))
+                + (x + 1 < width && isUnburnt(row[x + 1]))
+                + (y > 0 && isUnburnt(row[x - width]))
+                + (y + 1 < height && isUnburnt(row[x + width]));
+        }
+    }
+}
+
+WildfireStats computeWildfireStats(const WildfireCell* cells, int width, int height, uint32_t stepCount, const WildfireBurnedArea& burnedArea, WildfireThreadPool& threadPool)
+{
+    const int bandCount = (height + STATS_BAND_ROW_COUNT - 1) / STATS_BAND_ROW_COUNT;
+
+    std::vector<uint32_t> bandCounters((size_t)bandCount * WILDFIRE_STATS_COUNTER_COUNT, 0);
+    threadPool.parallelFor((size_t)bandCount, [&](size_t bandIndex) {
+        const int firstRow = (int)bandIndex * STATS_BAND_ROW_COUNT;
+        const int endRow = std::min(height, firstRow + STATS_BAND_ROW_COUNT);
+        accumulateBand(cells, width, height, firstRow, endRow, &bandCounters[bandIndex * WILDFIRE_STATS_COUNTER_COUNT]);
+    });
+
+    uint32_t counters[WILDFIRE_STATS_COUNTER_COUNT] = {};
+    for (int bandIndex = 0; bandIndex < bandCount; bandIndex++) {
+        for (int i = 0; i < WILDFIRE_STATS_COUNTER_COUNT; i++) {
+            counters[i] += bandCounters[(size_t)bandIndex * WILDFIRE_STATS_COUNTER_COUNT + i];
+        }
+    }
+
+    return makeWildfireStats(stepCount, counters, burnedArea);
+}
+
+////////////////////////////////////////////////////////////////////
+/// HISTORY
+////////////////////////////////////////////////////////////////////
+
+WildfireStatsHistory::WildfireStatsHistory(size_t capacity)
+    : records(capacity > 0 ? capacity : 1)
+{
+}
+
+void WildfireStatsHistory::push(const WildfireStats& stats)
+{
+    records[nextRecord] = stats;
+    nextRecord = (nextRecord + 1) % records.size();
+    count = std::min(count + 1, records.size());
+}
+
+void WildfireStatsHistory::clear()
+{
+    nextRecord = 0;
+    count = 0;
+}
+
+const WildfireStats& WildfireStatsHistory::get(size_t age) const
+{
+    return records[(nextRecord + records.size() - 1 - age % records.size()) % records.size()];
+}
+
+////////////////////////////////////////////////////////////////////
+/// CSV
+////////////////////////////////////////////////////////////////////
+
+bool WildfireStatsCsvWriter::open(const char* path)
+{
+    file.open(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create stats log: " << path << std::endl;
+        return false;
+    }
+
+    file << "step,burning,perimeter";
+    for (int material = 0; material < MATERIAL_COUNT; material++) {
+        file << ",burned_" << MATERIAL_NAMES[material];
+    }
+    file << "\n";
+
+    return true;
+}
+
+void WildfireStatsCsvWriter::close()
+{
+    if (isOpen()) {
+        file.close();
+    }
+}
+
+void WildfireStatsCsvWriter::write(const WildfireStats& stats)
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    file << stats.stepCount << ',' << stats.burningCellCount << ',' << stats.perimeterEdgeCount;
+    for (int material = 0; material < MATERIAL_COUNT; material++) {
+        file << ',' << stats.burnedCellCounts[material];
+    }
+    file << "\n";
+}
@@ -0,0 +1,102 @@
+#ifndef WILDFIRE_STATS_H
+#define WILDFIRE_STATS_H
+
+#include "WildfireRules.h"
+#include "WildfireThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Per step statistics of a grid: how much is burning, how long the fire front is and how
+// much of each material has burned. The compute shader reduces them on the GPU (see
+// WILDFIRE_STATS in Shaders/wildfireCompute.cs) and the CPU engines with a parallel
+// reduction, so a run can be monitored without reading back the grid.
+//
+// Burnt cells regrow, so the burned area cannot be read off the grid. Instead every step
+// counts the cells it sets on fire, and WildfireBurnedArea adds them up.
+//
+// ----------------------------------------------------------------------------
+
+// Counters in the order of a GPU stats record (STATS_BURNING, STATS_PERIMETER, STATS_IGNITED + material).
+constexpr int WILDFIRE_STATS_IGNITED_COUNTER = 2;
+constexpr int WILDFIRE_STATS_COUNTER_COUNT = WILDFIRE_STATS_IGNITED_COUNTER + MATERIAL_COUNT;
+
+struct WildfireStats
+{
+    // Steps simulated before the grid these numbers describe.
+    uint32_t stepCount = 0;
+
+    uint32_t burningCellCount = 0;
+
+    // Edges between a burning cell and an unburnt, non-water 4-neighbour. In cell widths,
+    // this is the length of the fire front.
+    uint32_t perimeterEdgeCount = 0;
+
+    // Cells set on fire so far, per material (MATERIAL_*). Regrowth does not take cells off
+    // again, and a regrown cell which burns again counts again.
+    uint32_t burnedCellCounts[MATERIAL_COUNT] = {};
+};
+
+// The cumulative burned area of a run.
+struct WildfireBurnedArea
+{
+    uint32_t cellCounts[MATERIAL_COUNT] = {};
+
+    // Start over from a grid whose history is unknown: its burning and burned out cells count.
+    void reset(const WildfireCell* cells, size_t cellCount);
+
+    // Add the cells a step set on fire, per material.
+    void add(const uint32_t* ignitedCounts);
+
+    // Add one cell set on fire.
+    void addIgnition(int material) { cellCounts[material < MATERIAL_COUNT ? material : MATERIAL_COUNT - 1]++; }
+};
+
+// Build the stats of a step from the counters of one GPU stats record. The record's ignitions
+// are not part of burnedArea yet: they describe the next grid.
+WildfireStats makeWildfireStats(uint32_t stepCount, const uint32_t* counters, const WildfireBurnedArea& burnedArea);
+
+// Reduce a row major grid in row bands across the pool. The burned area comes from burnedArea.
+WildfireStats computeWildfireStats(const WildfireCell* cells, int width, int height, uint32_t stepCount, const WildfireBurnedArea& burnedArea, WildfireThreadPool& threadPool);
+
+// The most recent stats, oldest dropped first.
+class WildfireStatsHistory
+{
+public:
+    explicit WildfireStatsHistory(size_t capacity = 4096);
+
+    void push(const WildfireStats& stats);
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // age 0 is the latest record.
+    const WildfireStats& get(size_t age) const;
+    const WildfireStats& getLatest() const { return get(0); }
+
+private:
+    std::vector<WildfireStats> records;
+    size_t nextRecord = 0;
+    size_t count = 0;
+};
+
+// One CSV row per step: step, burning, perimeter, then burned cells per material.
+class WildfireStatsCsvWriter
+{
+public:
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return file.is_open(); }
+
+    void write(const WildfireStats& stats);
+
+private:
+    std::ofstream file;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef WILDFIRE_THREAD_POOL_H
+#define WILDFIRE_THREAD_POOL_H
+
+#include "WildfireTrace.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads which run parallel-for loops. The calling thread takes part in
+// every loop, so a pool with a single thread runs everything inline.
+class WildfireThreadPool
+{
+public:
+    // threadCount == 0 uses every hardware thread.
+    explicit WildfireThreadPool(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (threadCount == 0)
+        {
+            threadCount = 1;
+        }
+
+        for (unsigned int i = 1; i < threadCount; i++)
+        {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~WildfireThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bIsShuttingDown = true;
+        }
+        wakeCondition.notify_all();
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    WildfireThreadPool(const WildfireThreadPool&) = delete;
+    WildfireThreadPool& operator=(const WildfireThreadPool&) = delete;
+
+    unsigned int getThreadCount() const
+    {
+        return (unsigned int)workers.size() + 1;
+    }
+
+    // Calls job(index) for every index in [0, count). Indices are handed out dynamically so
+    // uneven jobs balance across threads. Returns once every job has finished.
+    void parallelFor(size_t count, const std::function<void(size_t)>& job)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        if (workers.empty() || count == 1)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            jobCount = count;
+            nextIndex.store(0);
+            activeWorkers = (unsigned int)workers.size();
+            ++generation;
+        }
+        wakeCondition.notify_all();
+
+        runJobs(job, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this]() { return activeWorkers == 0; });
+        currentJob = nullptr;
+    }
+
+private:
+    void runJobs(const std::function<void(size_t)>& job, size_t count)
+    {
+        WILDFIRE_TRACE_ZONE("Parallel jobs");
+
+        for (size_t i = nextIndex.fetch_add(1); i < count; i = nextIndex.fetch_add(1))
+        {
+            job(i);
+        }
+    }
+
+    void workerLoop()
+    {
+        setWildfireTraceThreadName("Thread pool worker");
+
+        unsigned long long seenGeneration = 0;
+
+        while (true)
+        {
+            const std::function<void(size_t)>* job;
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeCondition.wait(lock, [&]() { return bIsShuttingDown || generation != seenGeneration; });
+                if (bIsShuttingDown)
+                {
+                    return;
+                }
+                seenGeneration = generation;
+                job = currentJob;
+                count = jobCount;
+            }
+
+            runJobs(*job, count);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --activeWorkers;
+            }
+            doneCondition.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(size_t)>* currentJob = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextIndex{ 0 };
+    unsigned int activeWorkers = 0;
+    unsigned long long generation = 0;
+    bool bIsShuttingDown = false;
+};
+
+#endif
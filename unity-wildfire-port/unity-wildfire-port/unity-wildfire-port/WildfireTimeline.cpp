@@ -0,0 +1,190 @@
+#include "WildfireTimeline.h"
+#include "WildfireSnapshot.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+void WildfireTimeline::reset(int newWidth, int newHeight, uint32_t newKeyframeInterval, size_t newMemoryBudget)
+{
+    width = newWidth;
+    height = newHeight;
+    keyframeInterval = std::max<uint32_t>(1, newKeyframeInterval);
+    memoryBudget = newMemoryBudget;
+
+    clear();
+}
+
+void WildfireTimeline::clear()
+{
+    keyframes.clear();
+    deltas.clear();
+    byteCount = 0;
+    deltaBytesSinceKeyframe = 0;
+    bIsKeyframeNeeded = false;
+    bHasSeekCells = false;
+}
+
+bool WildfireTimeline::isKeyframeDue(uint32_t step) const
+{
+    if (keyframes.empty() || bIsKeyframeNeeded) {
+        return true;
+    }
+
+    const auto lastKeyframe = keyframes.rbegin();
+    if (step <= lastKeyframe->first) {
+        return false;
+    }
+
+    return step - lastKeyframe->first >= keyframeInterval || deltaBytesSinceKeyframe >= lastKeyframe->second.bytes.size();
+}
+
+void WildfireTimeline::addKeyframe(uint32_t step, const WildfireCell* cells)
+{
+    const size_t cellCount = (size_t)width * height;
+
+    Keyframe& keyframe = keyframes[step];
+    byteCount -= keyframe.bytes.size();
+
+    keyframe.bytes.clear();
+    encodeWildfireCellPlane(cells, cellCount, offsetof(WildfireCell, material), keyframe.bytes);
+    keyframe.materialByteCount = keyframe.bytes.size();
+    encodeWildfireCellPlane(cells, cellCount, offsetof(WildfireCell, state), keyframe.bytes);
+    keyframe.bytes.shrink_to_fit();
+
+    byteCount += keyframe.bytes.size();
+
+    if (step == keyframes.rbegin()->first) {
+        deltaBytesSinceKeyframe = 0;
+        bIsKeyframeNeeded = false;
+    }
+
+    trimToBudget();
+}
+
+void WildfireTimeline::addDelta(uint32_t step, const WildfireCellChange* changes, size_t changeCount, size_t droppedCount)
+{
+    auto existing = deltas.find(step);
+    if (existing != deltas.end()) {
+        byteCount -= existing->second.size();
+        deltas.erase(existing);
+    }
+
+    if (droppedCount > 0) {
+        bIsKeyframeNeeded = true;
+        return;
+    }
+
+    // Ascending indices keep the gaps, and so the varints, small.
+    sortedChanges.assign(changes, changes + changeCount);
+    std::sort(sortedChanges.begin(), sortedChanges.end(), [](const WildfireCellChange& a, const WildfireCellChange& b) { return a.index < b.index; });
+
+    std::vector<uint8_t>& bytes = deltas[step];
+    bytes.reserve(changeCount * 3);
+
+    uint32_t previousIndex = 0;
+    for (const WildfireCellChange& change : sortedChanges) {
+        writeWildfireVarint((uint64_t)(change.index - previousIndex) << 2 | (change.cell.state & 3), bytes);
+        bytes.push_back(change.cell.material);
+        previousIndex = change.index;
+    }
+    bytes.shrink_to_fit();
+
+    byteCount += bytes.size();
+    if (!keyframes.empty() && step >= keyframes.rbegin()->first) {
+        deltaBytesSinceKeyframe += bytes.size();
+    }
+
+    trimToBudget();
+}
+
+uint32_t WildfireTimeline::getFirstStep() const
+{
+    return keyframes.empty() ? 0 : keyframes.begin()->first;
+}
+
+uint32_t WildfireTimeline::getLastStep() const
+{
+    if (keyframes.empty()) {
+        return 0;
+    }
+
+    uint32_t step = keyframes.rbegin()->first;
+    for (auto delta = deltas.find(step); delta != deltas.end() && delta->first == step; ++delta) {
+        ++step;
+    }
+
+    return step;
+}
+
+const std::vector<WildfireCell>* WildfireTimeline::seek(uint32_t step)
+{
+    auto keyframe = keyframes.upper_bound(step);
+    if (keyframe == keyframes.begin()) {
+        return nullptr;
+    }
+    --keyframe;
+
+    // Carry on from the last seek if it lies between the keyframe and the step.
+    const bool bContinueSeek = bHasSeekCells && seekStep <= step && seekStep >= keyframe->first;
+    const uint32_t startStep = bContinueSeek ? seekStep : keyframe->first;
+
+    // Every delta in between has to be there, or the step is unreachable.
+    const auto firstDelta = deltas.lower_bound(startStep);
+    auto delta = firstDelta;
+    for (uint32_t deltaStep = startStep; deltaStep < step; deltaStep++, ++delta) {
+        if (delta == deltas.end() || delta->first != deltaStep) {
+            return nullptr;
+        }
+    }
+
+    const size_t cellCount = (size_t)width * height;
+
+    if (!bContinueSeek) {
+        const Keyframe& frame = keyframe->second;
+        seekCells.resize(cellCount);
+        if (!decodeWildfireCellPlane(frame.bytes.data(), frame.materialByteCount, seekCells.data(), cellCount, offsetof(WildfireCell, material))
+            || !decodeWildfireCellPlane(frame.bytes.data() + frame.materialByteCount, frame.bytes.size() - frame.materialByteCount, seekCells.data(), cellCount, offsetof(WildfireCell, state))) {
+            bHasSeekCells = false;
+            return nullptr;
+        }
+    }
+
+    delta = firstDelta;
+    for (uint32_t deltaStep = startStep; deltaStep < step; deltaStep++, ++delta) {
+        const uint8_t* bytes = delta->second.data();
+        const uint8_t* end = bytes + delta->second.size();
+
+        uint64_t index = 0;
+        uint64_t packet;
+        while (bytes < end && readWildfireVarint(bytes, end, packet) && bytes < end) {
+            index += packet >> 2;
+            if (index < cellCount) {
+                seekCells[index].state = (uint8_t)(packet & 3);
+                seekCells[index].material = *bytes;
+            }
+            ++bytes;
+        }
+    }
+
+    bHasSeekCells = true;
+    seekStep = step;
+    return &seekCells;
+}
+
+// Drop the oldest keyframe and the deltas leading up to the next one. The latest keyframe is kept.
+void WildfireTimeline::trimToBudget()
+{
+    while (byteCount > memoryBudget && keyframes.size() > 1) {
+        const auto oldest = keyframes.begin();
+        const uint32_t nextKeyframeStep = std::next(oldest)->first;
+
+        byteCount -= oldest->second.bytes.size();
+        keyframes.erase(oldest);
+
+        while (!deltas.empty() && deltas.begin()->first < nextKeyframeStep) {
+            byteCount -= deltas.begin()->second.size();
+            deltas.erase(deltas.begin());
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef WILDFIRE_TIMELINE_H
+#define WILDFIRE_TIMELINE_H
+
+#include "WildfireRules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// In-memory history of a run, to scrub back and forth through it without re-simulating.
+//
+// Keyframes are full grids, compressed like the cell planes of a snapshot. Between them each
+// step keeps only the cells it changed: the gap to the previous changed index and the new
+// state share one varint, followed by the material byte, so a change costs about 3 bytes
+// instead of the 8 of a delta stream record. Seeking decodes the nearest keyframe at or before
+// the step and applies at most one keyframe interval of deltas. Seeking forward from the last
+// sought step only applies the deltas in between.
+//
+// Steps follow the snapshot convention: the grid at step S is the grid after S steps, and the
+// delta of step S turns it into the grid at step S + 1.
+//
+// ----------------------------------------------------------------------------
+
+class WildfireTimeline
+{
+public:
+    // keyframeInterval bounds the deltas a seek applies. Once the history holds more than
+    // memoryBudget bytes, the oldest keyframe and its deltas are dropped.
+    void reset(int width, int height, uint32_t keyframeInterval, size_t memoryBudget);
+
+    // Forget the history, e.g. when the grid was replaced by a snapshot.
+    void clear();
+
+    // Whether the grid at the step should be added as a keyframe: there is none yet, the interval
+    // has passed since the last one, the deltas since then have grown as large as a keyframe, or
+    // a step dropped changes.
+    bool isKeyframeDue(uint32_t step) const;
+
+    void addKeyframe(uint32_t step, const WildfireCell* cells);
+
+    // The changes of one step, in any order. A step which dropped changes (see
+    // DELTA_FRAME_OVERFLOWED) is not added, so the history cannot reach past it until the next
+    // keyframe, which is due at once.
+    void addDelta(uint32_t step, const WildfireCellChange* changes, size_t changeCount, size_t droppedCount = 0);
+
+    bool empty() const { return keyframes.empty(); }
+
+    // The range of steps a seek can reach, if not empty(). Gaps left by dropped deltas may
+    // still make a step in between unreachable.
+    uint32_t getFirstStep() const;
+    uint32_t getLastStep() const;
+
+    // The grid at the step, or nullptr if the history cannot reach it. Valid until the next seek.
+    const std::vector<WildfireCell>* seek(uint32_t step);
+
+    size_t getKeyframeCount() const { return keyframes.size(); }
+    size_t getDeltaCount() const { return deltas.size(); }
+    size_t getByteCount() const { return byteCount; }
+
+private:
+    struct Keyframe
+    {
+        size_t materialByteCount = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    void trimToBudget();
+
+    int width = 0;
+    int height = 0;
+    uint32_t keyframeInterval = 1;
+    size_t memoryBudget = 0;
+
+    std::map<uint32_t, Keyframe> keyframes;
+    std::map<uint32_t, std::vector<uint8_t>> deltas;
+    size_t byteCount = 0;
+
+    // Bytes of the deltas after the last keyframe, to add a keyframe early in a busy fire.
+    size_t deltaBytesSinceKeyframe = 0;
+    bool bIsKeyframeNeeded = false;
+
+    std::vector<WildfireCell> seekCells;
+    bool bHasSeekCells = false;
+    uint32_t seekStep = 0;
+
+    std::vector<WildfireCellChange> sortedChanges;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "WildfireTrace.h"
+
+#include <iostream>
+
+#if WILDFIRE_TRACING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct WildfireTraceEvent
+{
+    const char* name;
+    uint64_t startTime;
+    uint64_t endTime;
+};
+
+// Written by its thread only. writeCount publishes the events to writeWildfireTrace.
+struct WildfireTraceRing
+{
+    WildfireTraceEvent events[WILDFIRE_TRACE_RING_CAPACITY];
+    std::atomic<uint64_t> writeCount{ 0 };
+    std::atomic<const char*> threadName{ nullptr };
+    uint32_t threadId = 0;
+
+    // Events before this were already written out. Only touched under the registry lock.
+    uint64_t readCount = 0;
+};
+
+// Rings outlive their threads, so the zones of finished threads still make it into the trace.
+static std::mutex& getRingRegistryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<std::unique_ptr<WildfireTraceRing>>& getRingRegistry()
+{
+    static std::vector<std::unique_ptr<WildfireTraceRing>> rings;
+    return rings;
+}
+
+static WildfireTraceRing& getThreadRing()
+{
+    thread_local WildfireTraceRing* ring = nullptr;
+    if (ring == nullptr) {
+        std::unique_ptr<WildfireTraceRing> newRing(new WildfireTraceRing());
+
+        std::lock_guard<std::mutex> lock(getRingRegistryMutex());
+        std::vector<std::unique_ptr<WildfireTraceRing>>& rings = getRingRegistry();
+        newRing->threadId = (uint32_t)rings.size() + 1;
+        ring = newRing.get();
+        rings.push_back(std::move(newRing));
+    }
+    return *ring;
+}
+
+static void writeJsonString(std::ostream& file, const char* text)
+{
+    file << '"';
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            file << '\\';
+        }
+        if ((unsigned char)*c >= 0x20) {
+            file << *c;
+        }
+    }
+    file << '"';
+}
+
+uint64_t getWildfireTraceTime()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void recordWildfireTraceZone(const char* name, uint64_t startTime, uint64_t endTime)
+{
+    WildfireTraceRing& ring = getThreadRing();
+
+    const uint64_t count = ring.writeCount.load(std::memory_order_relaxed);
+    ring.events[count % WILDFIRE_TRACE_RING_CAPACITY] = WildfireTraceEvent{ name, startTime, endTime };
+    ring.writeCount.store(count + 1, std::memory_order_release);
+}
+
+void setWildfireTraceThreadName(const char* name)
+{
+    getThreadRing().threadName.store(name, std::memory_order_release);
+}
+
+bool writeWildfireTrace(const char* path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create trace: " << path << std::endl;
+        return false;
+    }
+
+    // Chrome trace timestamps are in microseconds.
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool bIsFirstEvent = true;
+    size_t eventCount = 0;
+
+    std::vector<WildfireTraceEvent> events;
+
+    std::lock_guard<std::mutex> lock(getRingRegistryMutex());
+    for (const std::unique_ptr<WildfireTraceRing>& ring : getRingRegistry()) {
+        const uint64_t endCount = ring->writeCount.load(std::memory_order_acquire);
+        const uint64_t startCount = std::max(ring->readCount, endCount > WILDFIRE_TRACE_RING_CAPACITY ? endCount - WILDFIRE_TRACE_RING_CAPACITY : 0);
+
+        events.clear();
+        for (uint64_t i = startCount; i < endCount; i++) {
+            events.push_back(ring->events[i % WILDFIRE_TRACE_RING_CAPACITY]);
+        }
+
+        // The thread kept recording while the events were copied. Drop any it may have overwritten.
+        const uint64_t laterCount = ring->writeCount.load(std::memory_order_acquire);
+        const uint64_t firstIntactCount = laterCount > WILDFIRE_TRACE_RING_CAPACITY ? laterCount - WILDFIRE_TRACE_RING_CAPACITY : 0;
+        const size_t firstIntactEvent = (size_t)(std::max(firstIntactCount, startCount) - startCount);
+
+        ring->readCount = endCount;
+
+        const char* threadName = ring->threadName.load(std::memory_order_acquire);
+        if (threadName != nullptr) {
+            file << (bIsFirstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId << ",\"args\":{\"name\":";
+            writeJsonString(file, threadName);
+            file << "}}";
+            bIsFirstEvent = false;
+        }
+
+        for (size_t i = std::min(firstIntactEvent, events.size()); i < events.size(); i++) {
+            const WildfireTraceEvent& event = events[i];
+            file << (bIsFirstEvent ? "" : ",\n") << "{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId << ",\"ts\":" << event.startTime * 1e-3 << ",\"dur\":" << (event.endTime - event.startTime) * 1e-3 << "}";
+            bIsFirstEvent = false;
+            ++eventCount;
+        }
+    }
+
+    file << "\n]}\n";
+    file.close();
+
+    if (!file) {
+        std::cerr << "Failed to write trace: " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "Wrote " << eventCount << " trace zones: " << path << std::endl;
+    return true;
+}
+
+#else
+
+void setWildfireTraceThreadName(const char*)
+{
+}
+
+bool writeWildfireTrace(const char* path)
+{
+    std::cerr << "Tracing is compiled out (WILDFIRE_TRACING), not writing " << path << std::endl;
+    return false;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef WILDFIRE_TRACE_H
+#define WILDFIRE_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+//
+// Scoped timing zones written out as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+//
+// Each thread records its zones into its own ring of WILDFIRE_TRACE_RING_CAPACITY events, so
+// recording takes no lock: the thread writes the event and then publishes it by bumping an
+// atomic count. Once a ring is full, the oldest events are overwritten. The ring is allocated
+// on the first zone a thread records.
+//
+// Zone names must be string literals (or otherwise outlive the trace), as only the pointer is
+// recorded.
+//
+// Building with WILDFIRE_TRACING 0 compiles every zone away.
+//
+// ----------------------------------------------------------------------------
+
+#ifndef WILDFIRE_TRACING
+#define WILDFIRE_TRACING 1
+#endif
+
+constexpr size_t WILDFIRE_TRACE_RING_CAPACITY = 1 << 16;
+
+#if WILDFIRE_TRACING
+
+// Nanoseconds since the first call, on a steady clock shared by every thread.
+uint64_t getWildfireTraceTime();
+
+// Record a finished zone on the calling thread's ring.
+void recordWildfireTraceZone(const char* name, uint64_t startTime, uint64_t endTime);
+
+// A zone from construction to end() or destruction, whichever comes first.
+class WildfireTraceZone
+{
+public:
+    explicit WildfireTraceZone(const char* zoneName) : name(zoneName), startTime(getWildfireTraceTime()) {}
+    ~WildfireTraceZone() { end(); }
+
+    WildfireTraceZone(const WildfireTraceZone&) = delete;
+    WildfireTraceZone& operator=(const WildfireTraceZone&) = delete;
+
+    void end()
+    {
+        if (name != nullptr) {
+            recordWildfireTraceZone(name, startTime, getWildfireTraceTime());
+            name = nullptr;
+        }
+    }
+
+private:
+    const char* name;
+    uint64_t startTime;
+};
+
+#else
+
+class WildfireTraceZone
+{
+public:
+    explicit WildfireTraceZone(const char*) {}
+    void end() {}
+};
+
+#endif
+
+#define WILDFIRE_TRACE_CONCAT_INNER(a, b) a##b
+#define WILDFIRE_TRACE_CONCAT(a, b) WILDFIRE_TRACE_CONCAT_INNER(a, b)
+
+// Time the rest of the enclosing scope.
+#define WILDFIRE_TRACE_ZONE(name) WildfireTraceZone WILDFIRE_TRACE_CONCAT(wildfireTraceZone, __LINE__)(name)
+
+// Name the calling thread in the trace. The name must outlive the trace.
+void setWildfireTraceThreadName(const char* name);
+
+// Write the zones recorded since the last write on every thread as Chrome trace JSON. Zones
+// being recorded while this runs may be left out. Returns false if the file cannot be
+// written, or if tracing is compiled out.
+bool writeWildfireTrace(const char* path);
+
+#endif
@@ -0,0 +1,191 @@
+#include "WildfireWindField.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+bool saveWildfireWindFrame(const char* path, int width, int height, const std::vector<glm::vec2>& vectors)
+{
+    WildfireWindFrameHeader header = {};
+    header.magic = WILDFIRE_WIND_FRAME_MAGIC;
+    header.version = WILDFIRE_WIND_FRAME_VERSION;
+    header.width = width;
+    header.height = height;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)vectors.data(), (std::streamsize)(vectors.size() * sizeof(glm::vec2)));
+
+    if (!file || vectors.size() != (size_t)width * height) {
+        std::cerr << "Failed to write wind frame: " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool loadWildfireWindFrame(const char* path, int& outWidth, int& outHeight, std::vector<glm::vec2>& outVectors)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open wind frame: " << path << std::endl;
+        return false;
+    }
+
+    WildfireWindFrameHeader header = {};
+    file.read((char*)&header, sizeof(header));
+
+    const bool bIsHeaderValid = file
+        && header.magic == WILDFIRE_WIND_FRAME_MAGIC
+        && header.version == WILDFIRE_WIND_FRAME_VERSION
+        && header.width > 0 && header.height > 0;
+
+    if (bIsHeaderValid) {
+        outVectors.resize((size_t)header.width * header.height);
+        file.read((char*)outVectors.data(), (std::streamsize)(outVectors.size() * sizeof(glm::vec2)));
+    }
+
+    if (!bIsHeaderValid || !file) {
+        std::cerr << "Not a valid wind frame: " << path << std::endl;
+        return false;
+    }
+
+    outWidth = header.width;
+    outHeight = header.height;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+/// FIELD
+////////////////////////////////////////////////////////////////////
+
+bool WildfireWindField::open(const char* manifestPath)
+{
+    std::ifstream manifest(manifestPath);
+    if (!manifest) {
+        std::cerr << "Failed to open wind field: " << manifestPath << std::endl;
+        return false;
+    }
+
+    // Frame paths are relative to the manifest.
+    const std::string manifestPathString = manifestPath;
+    const size_t directoryEnd = manifestPathString.find_last_of("/\\");
+    const std::string directory = directoryEnd == std::string::npos ? std::string() : manifestPathString.substr(0, directoryEnd + 1);
+
+    keyframes.clear();
+
+    Keyframe keyframe;
+    while (manifest >> keyframe.step >> keyframe.path) {
+        if (!keyframes.empty() && keyframe.step <= keyframes.back().step) {
+            std::cerr << "Wind field frames must be in increasing step order: " << manifestPath << std::endl;
+            keyframes.clear();
+            return false;
+        }
+
+        keyframe.path = directory + keyframe.path;
+        keyframes.push_back(keyframe);
+    }
+
+    if (keyframes.empty()) {
+        std::cerr << "Wind field has no frames: " << manifestPath << std::endl;
+        return false;
+    }
+
+    for (Slot& slot : slots) {
+        slot.keyframe = -1;
+    }
+
+    width = 0;
+    height = 0;
+    if (!loadSlot(0)) {
+        keyframes.clear();
+        return false;
+    }
+
+    return update(0);
+}
+
+bool WildfireWindField::loadSlot(int keyframe)
+{
+    Slot& slot = slots[keyframe % NUM_SLOTS];
+    if (slot.keyframe == keyframe) {
+        return true;
+    }
+
+    int frameWidth = 0;
+    int frameHeight = 0;
+    if (!loadWildfireWindFrame(keyframes[keyframe].path.c_str(), frameWidth, frameHeight, slot.vectors)) {
+        slot.keyframe = -1;
+        return false;
+    }
+
+    // The GPU copy is a texture array, so every frame has the size of the first.
+    if (width == 0) {
+        width = frameWidth;
+        height = frameHeight;
+    }
+    else if (frameWidth != width || frameHeight != height) {
+        std::cerr << "Wind frame " << keyframes[keyframe].path << " is " << frameWidth << "x" << frameHeight << ", expected " << width << "x" << height << std::endl;
+        slot.keyframe = -1;
+        return false;
+    }
+
+    slot.keyframe = keyframe;
+    slot.version++;
+    return true;
+}
+
+bool WildfireWindField::update(uint32_t step)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // The last frame at or before the step (the first frame before the forecast starts).
+    const auto firstLater = std::upper_bound(keyframes.begin(), keyframes.end(), step, [](uint32_t value, const Keyframe& keyframe) { return value < keyframe.step; });
+    const int previousKeyframe = std::max(0, (int)(firstLater - keyframes.begin()) - 1);
+    const int nextKeyframe = std::min(previousKeyframe + 1, (int)keyframes.size() - 1);
+
+    if (!loadSlot(previousKeyframe) || !loadSlot(nextKeyframe)) {
+        return false;
+    }
+
+    previousSlot = previousKeyframe % NUM_SLOTS;
+    nextSlot = nextKeyframe % NUM_SLOTS;
+
+    const uint32_t previousStep = keyframes[previousKeyframe].step;
+    const uint32_t nextStep = keyframes[nextKeyframe].step;
+    blend = nextStep > previousStep ? glm::clamp(((float)step - (float)previousStep) / (float)(nextStep - previousStep), 0.0f, 1.0f) : 0.0f;
+
+    return true;
+}
+
+glm::vec2 WildfireWindField::sampleSlot(int slot, glm::vec2 framePos) const
+{
+    const std::vector<glm::vec2>& vectors = slots[slot].vectors;
+
+    const glm::ivec2 corner = glm::ivec2(glm::floor(framePos));
+    const glm::vec2 weight = framePos - glm::vec2(corner);
+
+    const int x0 = glm::clamp(corner.x, 0, width - 1);
+    const int x1 = glm::clamp(corner.x + 1, 0, width - 1);
+    const int y0 = glm::clamp(corner.y, 0, height - 1);
+    const int y1 = glm::clamp(corner.y + 1, 0, height - 1);
+
+    const glm::vec2 bottom = glm::mix(vectors[(size_t)y0 * width + x0], vectors[(size_t)y0 * width + x1], weight.x);
+    const glm::vec2 top = glm::mix(vectors[(size_t)y1 * width + x0], vectors[(size_t)y1 * width + x1], weight.x);
+    return glm::mix(bottom, top, weight.y);
+}
+
+glm::vec2 WildfireWindField::sample(glm::ivec2 cellCoord, glm::ivec2 gridSize) const
+{
+    // Texel centers of the frame sit at (i + 0.5) / width, like a texture covering the grid.
+    const glm::vec2 uv = (glm::vec2(cellCoord) + 0.5f) / glm::vec2(gridSize);
+    const glm::vec2 framePos = uv * glm::vec2(width, height) - 0.5f;
+
+    const glm::vec2 previous = sampleSlot(previousSlot, framePos);
+    if (nextSlot == previousSlot || blend <= 0.0f) {
+        return previous;
+    }
+    return glm::mix(previous, sampleSlot(nextSlot, framePos), blend);
+}
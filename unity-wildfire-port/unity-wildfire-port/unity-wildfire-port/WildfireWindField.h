@@ -0,0 +1,104 @@
+#ifndef WILDFIRE_WIND_FIELD_H
+#define WILDFIRE_WIND_FIELD_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+//
+// Spatially varying wind from a gridded forecast. The forecast is a series of coarse frames of
+// wind vectors, each valid at a simulation step. Between two frames the wind is blended
+// linearly in time, and within a frame it is interpolated bilinearly over the grid, so the
+// frames can be far coarser and further apart than the cells and steps of the simulation.
+//
+// Only the two frames around the current step are resident. Crossing into the next forecast
+// interval loads one frame into the slot the oldest frame used, so a GPU copy of the slots is
+// updated with one small upload per forecast frame and a blend factor per step.
+//
+// Manifest: a text file with one "<step> <frame file>" line per frame, in step order. Frame
+// paths are relative to the manifest.
+//
+// Frame file (little endian):
+//   WildfireWindFrameHeader
+//   float x, y per vector, row major from the bottom row of the grid
+//
+// A vector uses the units of the compass wind directions (x east, y north, GetWindDirection).
+//
+// ----------------------------------------------------------------------------
+
+struct WildfireWindFrameHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+};
+
+static_assert(sizeof(WildfireWindFrameHeader) == 16, "The wind frame header layout must not change");
+
+constexpr uint32_t WILDFIRE_WIND_FRAME_MAGIC = 0x444E5757; // "WWND"
+constexpr uint32_t WILDFIRE_WIND_FRAME_VERSION = 1;
+
+bool saveWildfireWindFrame(const char* path, int width, int height, const std::vector<glm::vec2>& vectors);
+bool loadWildfireWindFrame(const char* path, int& outWidth, int& outHeight, std::vector<glm::vec2>& outVectors);
+
+class WildfireWindField
+{
+public:
+    static constexpr int NUM_SLOTS = 2;
+
+    // Read the manifest and the first frame, which sets the size of every frame.
+    bool open(const char* manifestPath);
+    bool isOpen() const { return !keyframes.empty(); }
+
+    // Make the frames around step resident and set the blend between them. Returns false if a
+    // frame failed to load, in which case the previous frames stay in use.
+    bool update(uint32_t step);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // The frame in each slot. The version changes whenever a slot is loaded with another frame.
+    const std::vector<glm::vec2>& getSlotVectors(int slot) const { return slots[slot].vectors; }
+    uint32_t getSlotVersion(int slot) const { return slots[slot].version; }
+
+    // The wind at this step is mix(previous slot, next slot, blend).
+    int getPreviousSlot() const { return previousSlot; }
+    int getNextSlot() const { return nextSlot; }
+    float getBlend() const { return blend; }
+
+    // The wind at the center of a cell of a gridSize grid, blended like a GL_LINEAR texture
+    // array sample with clamp to edge.
+    glm::vec2 sample(glm::ivec2 cellCoord, glm::ivec2 gridSize) const;
+
+private:
+    struct Keyframe
+    {
+        uint32_t step;
+        std::string path;
+    };
+
+    struct Slot
+    {
+        int keyframe = -1;
+        uint32_t version = 0;
+        std::vector<glm::vec2> vectors;
+    };
+
+    bool loadSlot(int keyframe);
+    glm::vec2 sampleSlot(int slot, glm::vec2 framePos) const;
+
+    std::vector<Keyframe> keyframes;
+    int width = 0;
+    int height = 0;
+
+    Slot slots[NUM_SLOTS];
+    int previousSlot = 0;
+    int nextSlot = 0;
+    float blend = 0.0f;
+};
+
+#endif
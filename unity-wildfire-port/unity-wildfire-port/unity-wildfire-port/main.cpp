@@ -24,6 +24,25 @@
 #include "Model.h"
 
 #include <vector>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <map>
+#include <memory>
+
+#include "WildfireDefinitions.h"
+#include "WildfireLandscape.h"
+#include "WildfireRules.h"
+#include "WildfireHeadless.h"
+#include "WildfireSnapshot.h"
+#include "WildfireEventLog.h"
+#include "WildfireDeltaStream.h"
+#include "WildfireStats.h"
+#include "WildfireTimeline.h"
+#include "WildfireProfiler.h"
+#include "WildfireTrace.h"
+#include "WildfireWindField.h"
+#include "WildfireShaderDefinitions.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
@@ -37,27 +56,18 @@
 /// MACROS AND CONSTANT VALUES
 ////////////////////////////////////////////////////////////////////
 
-#define MATERIAL_GRASS 0.0f
-#define MATERIAL_WATER 1.0f
-#define MATERIAL_BEDROCK 2.0f
-#define MATERIAL_TREE_1 3.0f
-#define MATERIAL_TREE_2 4.0f
-#define MATERIAL_TREE_3 5.0f
-
-#define STATE_NOT_ON_FIRE 0.0f
-#define STATE_ON_FIRE 1.0f
-#define STATE_DESTROYED 2.0f
-
 constexpr unsigned int SCREEN_WIDTH = 800;
 constexpr unsigned int SCREEN_HEIGHT = 600;
-constexpr unsigned int WILDFIRE_WIDTH = 2048;
-constexpr unsigned int WILDFIRE_HEIGHT = 2048;
 constexpr unsigned int NUM_PATCH_PTS = 4;
 constexpr unsigned int VERTICES_RESOLUTION_FACTOR = 20;
 
+constexpr unsigned int WILDFIRE_TIMER_TEXTURE_INDEX = 0;
 constexpr unsigned int LANDSCAPE_TEXTURE_INDEX = 1;
 constexpr unsigned int WILDFIRE_TEXTURE_INDEX = 2;
+constexpr unsigned int WILDFIRE_HEIGHT_TEXTURE_INDEX = 4;
+constexpr unsigned int WILDFIRE_SLOPE_TEXTURE_INDEX = 5;
 constexpr unsigned int HEIGHTMAP_TEXTURE_INDEX = 6;
+constexpr unsigned int WIND_FIELD_TEXTURE_INDEX = 7;
 
 // Define the file path for the heightmap image.
 const char* HEIGHTMAP_FILE_NAME = "HeightMaps/GreatLakeHeightmap.png";
@@ -75,6 +85,71 @@ const char* TREE_FOLIAGE_FRAGMENT_SHADER = "Shaders/treeModel.frag";
 
 const char* WILDFIRE_COMPUTE_SHADER = "Shaders/wildfireCompute.cs";
 
+// F5 saves the simulation to this file and F9 restores it.
+const char* WILDFIRE_SNAPSHOT_FILE_NAME = "wildfire.snapshot";
+
+// Every ignition, parameter change and wind change of the session is logged here, for `--headless --replay`.
+constexpr bool RECORD_WILDFIRE_EVENTS = true;
+const char* WILDFIRE_EVENT_LOG_FILE_NAME = "wildfire.events";
+
+// Stream the cells each step changed to this file (or named pipe). The compute shader appends
+// them to a buffer, and a ring of buffers lets the readback trail the GPU by a few steps.
+constexpr bool STREAM_WILDFIRE_CHANGES = true;
+const char* WILDFIRE_DELTA_STREAM_FILE_NAME = "wildfire.deltas";
+constexpr GLuint WILDFIRE_CHANGE_BUFFER_BINDING = 0;
+constexpr int NUM_WILDFIRE_CHANGE_BUFFERS = 3;
+
+// Room for changes per step, as a fraction of the grid. A step which changes more cells
+// is flagged as overflowed in the stream and a snapshot is saved to resync from.
+constexpr int WILDFIRE_CHANGE_CAPACITY_DIVISOR = 16;
+
+// Keep a history of the run in memory to scrub through (see WildfireTimeline.h): a keyframe
+// of the grid at least every WILDFIRE_TIMELINE_KEYFRAME_INTERVAL steps plus the change stream
+// in between, so no step costs more than one keyframe decode and one interval of deltas.
+// The left and right arrow keys pause the simulation and step through the history, page up
+// and page down jump a keyframe interval, home goes to the oldest step kept, and end resumes.
+// Needs STREAM_WILDFIRE_CHANGES.
+constexpr bool RECORD_WILDFIRE_TIMELINE = true;
+constexpr uint32_t WILDFIRE_TIMELINE_KEYFRAME_INTERVAL = 64;
+constexpr size_t WILDFIRE_TIMELINE_MEMORY_BUDGET = (size_t)512 << 20;
+
+// Reduce burning cells, front perimeter and burned area per material on the GPU every step.
+// Each step adds into one record of a small ring, which is read back once the step's fence
+// signals, and the results are logged to the CSV file (nullptr for none).
+constexpr bool COLLECT_WILDFIRE_STATS = true;
+const char* WILDFIRE_STATS_CSV_FILE_NAME = "wildfire_stats.csv";
+constexpr GLuint WILDFIRE_STATS_BUFFER_BINDING = 1;
+constexpr int NUM_WILDFIRE_STATS_RECORDS = 4;
+
+// The tiled kernel steps TILE_SIZE x TILE_SIZE cells per workgroup out of shared memory.
+// Set to false to run the reference kernel (one cell per workgroup) for comparison.
+constexpr bool USE_TILED_WILDFIRE_KERNEL = true;
+constexpr unsigned int WILDFIRE_TILE_SIZE = 16;
+
+// The wind and flammable probabilities reach the compute shader as a rule table buffer.
+constexpr GLuint WILDFIRE_RULE_TABLE_BUFFER_BINDING = 2;
+
+// Time the compute step, the state readback, the terrain and the trees on the GPU and the CPU
+// every frame (see WildfireProfiler.h), with their history in an ImGui overlay. F1 toggles it.
+constexpr bool PROFILE_FRAME_PASSES = true;
+const char* IMGUI_GLSL_VERSION = "#version 430";
+
+// Startup and frame phases are traced into per-thread rings (see WildfireTrace.h). Startup is
+// written out once the first frame is about to render, and the last frames of the session on
+// exit. Open the files in ui.perfetto.dev or chrome://tracing. nullptr writes no file.
+const char* WILDFIRE_STARTUP_TRACE_FILE_NAME = "wildfire_startup_trace.json";
+const char* WILDFIRE_FRAME_TRACE_FILE_NAME = "wildfire_frame_trace.json";
+
+// Z and C turn a continuous wind by this many degrees.
+constexpr float WIND_ANGLE_STEP_DEGREES = 15.0f;
+
+// Manifest of a gridded wind forecast (see WildfireWindField.h) which replaces the global wind,
+// or nullptr to steer the wind with the keys.
+const char* WILDFIRE_WIND_FIELD_FILE_NAME = nullptr;
+
+// Key of the wildfire random numbers. Runs with the same seed and inputs evolve identically.
+constexpr uint64_t WILDFIRE_SEED = 0;
+
 constexpr int TREE_GRID_DIMENSION_X = 4;
 constexpr int TREE_GRID_DIMENSION_Y = 4;
 constexpr int NUMBER_OF_PIXELS_IN_TREE_GRID = TREE_GRID_DIMENSION_X * TREE_GRID_DIMENSION_Y;
@@ -88,9 +163,6 @@ const int TREE_GRID_PIXEL_OFFSETS[NUMBER_OF_PIXELS_IN_TREE_GRID][2] = {
     {0, 3}, {1, 3}, {2, 3}, {3, 3},
 };
 
-const int NUMBER_OF_TREE_GRIDS_X = WILDFIRE_HEIGHT / NUMBER_OF_PIXELS_IN_TREE_GRID;
-const int NUMBER_OF_TREE_GRIDS_Y = WILDFIRE_WIDTH / NUMBER_OF_PIXELS_IN_TREE_GRID;
-
 // Change this speed to affect how fast you want the camera to zip around the terrain.
 constexpr float CAMERA_SPEED = 1000.f;
 
@@ -121,95 +193,694 @@ glm::vec2 mousePos = glm::vec2(0.0f, 0.0f);
 
 int TreeModelInstanceCount = 0;
 
+// Size of the simulation grid, taken from the loaded landscape (see loadWildfireLandscape).
+int wildfireWidth = 0;
+int wildfireHeight = 0;
+
+// World space extent of the terrain mesh, which spans the heightmap image one unit per pixel.
+glm::vec2 terrainWorldSize = glm::vec2(0.0f, 0.0f);
+
 GLFWwindow* mainWindow = nullptr;
 
+// The wildfire textures are double buffered: each step reads the current texture and writes
+// the other one, then the two swap roles. Nothing is copied between them.
+constexpr GLsizei NUM_WILDFIRE_TEXTURES = 2;
+GLuint wildfireTextures[NUM_WILDFIRE_TEXTURES];
+int currentWildfireTextureIndex = 0;
+
+// Number of compute steps dispatched so far. Keys the random numbers together with WILDFIRE_SEED.
+unsigned int wildfireSimulationStep = 0;
+
+// The compute shader's parameter uniforms. Q and E turn the wind.
+WildfireParameters wildfireParameters;
+WildfireEventRecorder wildfireEventRecorder;
+
+GLuint wildfireRuleTableBuffer = 0;
+WildfireRuleTableCache wildfireRuleTableCache;
+
+// Compiled permutations of the compute shader, keyed by their WILDFIRE_SHADER_RULES bits.
+std::map<uint32_t, std::unique_ptr<ComputeShader>> wildfireComputeVariants;
+
+// The two resident forecast frames, one per layer. A layer is only uploaded when its slot
+// is loaded with a new frame, so a step between forecast frames only sets the blend uniform.
+WildfireWindField wildfireWindField;
+GLuint wildfireWindFieldTexture = 0;
+uint32_t uploadedWindFieldVersions[WildfireWindField::NUM_SLOTS] = {};
+
+// Burnout and regrowth timers (see SampleTimer in WildfireRules.h), updated in place by the
+// compute step. They are redrawn on the next step when stale, e.g. after a snapshot without
+// timers was restored, or when a regrowth probability differs from the one they were drawn with.
+GLuint wildfireTimerTexture = 0;
+bool bAreWildfireTimersStale = true;
+float wildfireTimerGrassRegrowProbability = 0.0f;
+float wildfireTimerTreeRegrowProbability = 0.0f;
+
+// Change buffers: a uint count (plus padding) followed by WildfireCellChange records.
+GLuint wildfireChangeBuffers[NUM_WILDFIRE_CHANGE_BUFFERS];
+GLsync wildfireChangeFences[NUM_WILDFIRE_CHANGE_BUFFERS] = {};
+unsigned int wildfireChangeSteps[NUM_WILDFIRE_CHANGE_BUFFERS];
+uint32_t wildfireChangeFlags[NUM_WILDFIRE_CHANGE_BUFFERS];
+GLsizeiptr wildfireChangeCapacity = 0;
+int nextWildfireChangeBuffer = 0;
+bool bIsWildfireGridReplaced = false;
+WildfireDeltaStreamWriter wildfireDeltaStream;
+
+// Keyframes are read back like snapshots, through their own pixel buffer.
+WildfireTimeline wildfireTimeline;
+GLuint wildfireKeyframeBuffer = 0;
+GLsync wildfireKeyframeFence = nullptr;
+unsigned int wildfireKeyframeStep = 0;
+
+// While scrubbing, the simulation is paused and the terrain shows the step from the timeline.
+bool bIsScrubbingWildfireTimeline = false;
+unsigned int wildfireTimelineScrubStep = 0;
+int requestedTimelineScrubOffset = 0;
+bool bIsTimelineResumeRequested = false;
+
+WildfireProfiler frameProfiler;
+int computeStepPass = 0;
+int stateReadbackPass = 0;
+int terrainPass = 0;
+int treePass = 0;
+bool bIsProfilerOverlayVisible = true;
+
+// Stats ring: NUM_WILDFIRE_STATS_RECORDS records of WILDFIRE_STATS_COUNTER_COUNT uints.
+GLuint wildfireStatsBuffer = 0;
+GLsync wildfireStatsFences[NUM_WILDFIRE_STATS_RECORDS] = {};
+unsigned int wildfireStatsSteps[NUM_WILDFIRE_STATS_RECORDS];
+int nextWildfireStatsRecord = 0;
+WildfireStatsHistory wildfireStatsHistory;
+
+// Summed from the ignitions of every stats record read back so far.
+WildfireBurnedArea wildfireBurnedArea;
+WildfireStatsCsvWriter wildfireStatsCsv;
+
+// Snapshots are read back asynchronously: the current texture is copied into a pixel buffer,
+// and the buffer is only mapped once its fence has signalled, so the render loop never stalls.
+bool bIsSnapshotSaveRequested = false;
+bool bIsSnapshotLoadRequested = false;
+GLuint wildfireSnapshotBuffer = 0;
+GLsync wildfireSnapshotFence = nullptr;
+unsigned int wildfireSnapshotStep = 0;
+bool bWildfireSnapshotHasTimers = false;
+
+// The texture holding the latest simulation state. Everything outside the compute step reads this one.
+GLuint getCurrentWildfireTexture() {
+    return wildfireTextures[currentWildfireTextureIndex];
+}
+
+// Set the rule parameters on the compute shader (the seed and the per step inputs are set separately).
+// The wind and the flammable probabilities go through updateWildfireRuleTable instead, and the
+// rule switches select the shader permutation (getWildfireComputeVariant).
+void setWildfireParameterUniforms(const ComputeShader& shader, const WildfireParameters& parameters) {
+    shader.setFloat("FIRE_PROB", parameters.fireProbability);
+    shader.setFloat("GRASS_REGROW_PROBABILITY", parameters.grassRegrowProbability);
+    shader.setFloat("TREE_REGROW_PROBABILITY", parameters.treeRegrowProbability);
+}
+
+void createWildfireRuleTableBuffer() {
+    glGenBuffers(1, &wildfireRuleTableBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireRuleTableBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(WildfireRuleTable), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WILDFIRE_RULE_TABLE_BUFFER_BINDING, wildfireRuleTableBuffer);
+}
+
+// Upload a new rule table when the wind or a flammable probability has changed since the last step.
+void updateWildfireRuleTable(const WildfireParameters& parameters) {
+    if (wildfireRuleTableCache.update(parameters)) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireRuleTableBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(WildfireRuleTable), &wildfireRuleTableCache.get());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+void createWildfireWindFieldTexture() {
+    glGenTextures(1, &wildfireWindFieldTexture);
+    glActiveTexture(GL_TEXTURE0 + WIND_FIELD_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, wildfireWindFieldTexture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RG32F, wildfireWindField.getWidth(), wildfireWindField.getHeight(), WildfireWindField::NUM_SLOTS);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+// Advance the wind field to the step. Returns true if the step uses it.
+bool advanceWildfireWindField(unsigned int step) {
+    return wildfireWindField.isOpen() && wildfireWindField.update(step);
+}
+
+// Upload the wind field frames which changed and set the blend.
+void updateWildfireWindField(const ComputeShader& shader) {
+    for (int slot = 0; slot < WildfireWindField::NUM_SLOTS; slot++) {
+        if (uploadedWindFieldVersions[slot] != wildfireWindField.getSlotVersion(slot)) {
+            glActiveTexture(GL_TEXTURE0 + WIND_FIELD_TEXTURE_INDEX);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, wildfireWindFieldTexture);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot, wildfireWindField.getWidth(), wildfireWindField.getHeight(), 1, GL_RG, GL_FLOAT, wildfireWindField.getSlotVectors(slot).data());
+            uploadedWindFieldVersions[slot] = wildfireWindField.getSlotVersion(slot);
+        }
+    }
+
+    shader.setIVec2("windFieldLayers", wildfireWindField.getPreviousSlot(), wildfireWindField.getNextSlot());
+    shader.setFloat("windFieldBlend", wildfireWindField.getBlend());
+}
+
+// The texture the next compute step writes into.
+GLuint getNextWildfireTexture() {
+    return wildfireTextures[1 - currentWildfireTextureIndex];
+}
+
+// The defines which select the wildfire kernel variant.
+std::string getWildfireComputeDefines() {
+    std::string defines = getWildfireShaderDefinitions();
+
+    if (USE_TILED_WILDFIRE_KERNEL) {
+        defines += "#define WILDFIRE_TILED 1\n#define TILE_SIZE " + std::to_string(WILDFIRE_TILE_SIZE) + "\n";
+    }
+
+    if (STREAM_WILDFIRE_CHANGES) {
+        defines += "#define WILDFIRE_EMIT_CHANGES 1\n";
+    }
+
+    if (COLLECT_WILDFIRE_STATS) {
+        defines += "#define WILDFIRE_STATS 1\n";
+    }
+
+    return defines;
+}
+
+// The compute shader permutation for the rules, compiled on first use.
+ComputeShader& getWildfireComputeVariant(uint32_t rules) {
+    rules &= WILDFIRE_SHADER_RULES;
+
+    std::unique_ptr<ComputeShader>& variant = wildfireComputeVariants[rules];
+    if (variant == nullptr) {
+        variant.reset(new ComputeShader(WILDFIRE_COMPUTE_SHADER, getWildfireComputeDefines() + getWildfireRuleShaderDefines(rules)));
+    }
+
+    return *variant;
+}
+
+// Number of workgroups needed to cover the grid along one axis.
+GLuint getWildfireDispatchSize(GLuint gridSize) {
+    const GLuint tileSize = USE_TILED_WILDFIRE_KERNEL ? WILDFIRE_TILE_SIZE : 1;
+    return (gridSize + tileSize - 1) / tileSize;
+}
+
+// Bind the current texture as the compute shader's input (image unit 2) and the next one as its output (image unit 3).
+void bindWildfireImagesForStep() {
+    glBindImageTexture(WILDFIRE_TEXTURE_INDEX, getCurrentWildfireTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG8UI);
+    glBindImageTexture(WILDFIRE_TEXTURE_INDEX + 1, getNextWildfireTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG8UI);
+}
+
+// Make the texture that was just written the current one, and point the terrain sampler at it.
+void swapWildfireTextures() {
+    currentWildfireTextureIndex = 1 - currentWildfireTextureIndex;
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
+}
+
 ////////////////////////////////////////////////////////////////////
-/// GENERATE WILDFIRE TEXTURE
+/// CHANGE STREAM
 ////////////////////////////////////////////////////////////////////
 
-GLboolean generateWildfireTexture(GLsizei offset, GLuint* textures, GLsizei width, GLsizei height) {
-    
-    const size_t pixelCount = width * height;
+void createWildfireChangeBuffers() {
+    wildfireChangeCapacity = std::max<GLsizeiptr>(1, (GLsizeiptr)wildfireWidth * wildfireHeight / WILDFIRE_CHANGE_CAPACITY_DIVISOR);
 
-    // We give each pixel 4 array cells to work with.
-    // data[0] - Material Type
-    // data[1] - Current State (Not On Fire to Start With)
-    // data[2] - World Height Value (Normalized)
-    float* texture_data = new float[pixelCount * 4];
+    glGenBuffers(NUM_WILDFIRE_CHANGE_BUFFERS, wildfireChangeBuffers);
+    for (int i = 0; i < NUM_WILDFIRE_CHANGE_BUFFERS; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireChangeBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint) + wildfireChangeCapacity * sizeof(WildfireCellChange), nullptr, GL_DYNAMIC_READ);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
-    ////////////////////////////////////////////////////////////////////
-    /// READ FROM HEIGHTMAP TEXTURE
-    ////////////////////////////////////////////////////////////////////
+// Write the changes of one finished step to the stream and free its buffer.
+void writeWildfireChanges(int bufferIndex) {
+    glDeleteSync(wildfireChangeFences[bufferIndex]);
+    wildfireChangeFences[bufferIndex] = nullptr;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireChangeBuffers[bufferIndex]);
+
+    GLuint changeCount = 0;
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &changeCount);
+
+    const GLsizeiptr writtenCount = std::min<GLsizeiptr>(changeCount, wildfireChangeCapacity);
+    const WildfireCellChange* changes = writtenCount > 0
+        ? (const WildfireCellChange*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint), writtenCount * sizeof(WildfireCellChange), GL_MAP_READ_BIT)
+        : nullptr;
+
+    const unsigned int step = wildfireChangeSteps[bufferIndex];
+    wildfireDeltaStream.writeFrame(step, wildfireChangeFlags[bufferIndex], changes, changes != nullptr ? (size_t)writtenCount : 0, (size_t)(changeCount - writtenCount));
+    if (RECORD_WILDFIRE_TIMELINE) {
+        wildfireTimeline.addDelta(step, changes, changes != nullptr ? (size_t)writtenCount : 0, (size_t)(changeCount - writtenCount));
+    }
+
+    if (changes != nullptr) {
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Consumers can only catch up again from a full state.
+    if ((GLsizeiptr)changeCount > wildfireChangeCapacity) {
+        std::cerr << "Step " << step << " changed " << changeCount << " cells, more than the change buffer holds. Saving a snapshot to resync from." << std::endl;
+        bIsSnapshotSaveRequested = true;
+    }
+}
+
+// Stream every step whose changes have arrived, oldest first. With bShouldWait the oldest
+// pending step is waited for, so its buffer can be reused.
+void pollWildfireChanges(bool bShouldWait) {
+    for (int i = 0; i < NUM_WILDFIRE_CHANGE_BUFFERS; i++) {
+        const int bufferIndex = (nextWildfireChangeBuffer + i) % NUM_WILDFIRE_CHANGE_BUFFERS;
+        if (wildfireChangeFences[bufferIndex] == nullptr) {
+            continue;
+        }
+
+        const GLuint64 timeout = bShouldWait ? GL_TIMEOUT_IGNORED : 0;
+        const GLenum status = glClientWaitSync(wildfireChangeFences[bufferIndex], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return;
+        }
+
+        writeWildfireChanges(bufferIndex);
+        bShouldWait = false;
+    }
+}
+
+// Bind a cleared change buffer for the next compute step.
+void bindWildfireChangeBufferForStep() {
+    // The ring is full: the oldest step has to be written out before its buffer is reused.
+    if (wildfireChangeFences[nextWildfireChangeBuffer] != nullptr) {
+        pollWildfireChanges(true);
+    }
+
+    const GLuint buffer = wildfireChangeBuffers[nextWildfireChangeBuffer];
+    const GLuint zero = 0;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WILDFIRE_CHANGE_BUFFER_BINDING, buffer);
+}
+
+// Fence the step just dispatched and move on to the next buffer of the ring.
+void endWildfireChangeStep(unsigned int step) {
+    // The buffer is read back through glGetBufferSubData and glMapBufferRange.
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    wildfireChangeFences[nextWildfireChangeBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    wildfireChangeSteps[nextWildfireChangeBuffer] = step;
+    wildfireChangeFlags[nextWildfireChangeBuffer] = bIsWildfireGridReplaced ? DELTA_FRAME_DISCONTINUOUS : 0;
+    bIsWildfireGridReplaced = false;
+    nextWildfireChangeBuffer = (nextWildfireChangeBuffer + 1) % NUM_WILDFIRE_CHANGE_BUFFERS;
+}
+
+////////////////////////////////////////////////////////////////////
+/// STATS
+////////////////////////////////////////////////////////////////////
+
+constexpr GLsizeiptr WILDFIRE_STATS_RECORD_SIZE = WILDFIRE_STATS_COUNTER_COUNT * sizeof(GLuint);
 
-    int heightmap_img_width, heightmap_img_height, heightmap_channels;
-    unsigned char* heightmap_image_data = stbi_load(HEIGHTMAP_FILE_NAME, &heightmap_img_width, &heightmap_img_height, &heightmap_channels, STBI_grey);
+void createWildfireStatsBuffer() {
+    glGenBuffers(1, &wildfireStatsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireStatsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_WILDFIRE_STATS_RECORDS * WILDFIRE_STATS_RECORD_SIZE, nullptr, GL_DYNAMIC_READ);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WILDFIRE_STATS_BUFFER_BINDING, wildfireStatsBuffer);
+}
+
+// Read the record of every step which has finished, oldest first. With bShouldWait the
+// oldest pending step is waited for, so its record can be reused.
+void pollWildfireStats(bool bShouldWait) {
+    for (int i = 0; i < NUM_WILDFIRE_STATS_RECORDS; i++) {
+        const int recordIndex = (nextWildfireStatsRecord + i) % NUM_WILDFIRE_STATS_RECORDS;
+        if (wildfireStatsFences[recordIndex] == nullptr) {
+            continue;
+        }
+
+        const GLuint64 timeout = bShouldWait ? GL_TIMEOUT_IGNORED : 0;
+        const GLenum status = glClientWaitSync(wildfireStatsFences[recordIndex], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return;
+        }
+
+        glDeleteSync(wildfireStatsFences[recordIndex]);
+        wildfireStatsFences[recordIndex] = nullptr;
+
+        GLuint counters[WILDFIRE_STATS_COUNTER_COUNT];
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireStatsBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, recordIndex * WILDFIRE_STATS_RECORD_SIZE, WILDFIRE_STATS_RECORD_SIZE, counters);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        const WildfireStats stats = makeWildfireStats(wildfireStatsSteps[recordIndex], counters, wildfireBurnedArea);
+        wildfireBurnedArea.add(&counters[WILDFIRE_STATS_IGNITED_COUNTER]);
+        wildfireStatsHistory.push(stats);
+        wildfireStatsCsv.write(stats);
+
+        bShouldWait = false;
+    }
+}
 
-    if (!heightmap_image_data) {
-        std::cerr << "Failed to load heightmap image: " << HEIGHTMAP_FILE_NAME << std::endl;
+// Clear the next record of the ring and point the compute shader at it.
+void bindWildfireStatsRecordForStep(const ComputeShader& shader) {
+    // The ring is full: the oldest step has to be read before its record is reused.
+    if (wildfireStatsFences[nextWildfireStatsRecord] != nullptr) {
+        pollWildfireStats(true);
+    }
+
+    const GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, wildfireStatsBuffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, nextWildfireStatsRecord * WILDFIRE_STATS_RECORD_SIZE, WILDFIRE_STATS_RECORD_SIZE, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    shader.setUInt("statsRecordIndex", (unsigned int)nextWildfireStatsRecord);
+}
+
+// Fence the step just dispatched and move on to the next record of the ring.
+void endWildfireStatsStep(unsigned int step) {
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    wildfireStatsFences[nextWildfireStatsRecord] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    wildfireStatsSteps[nextWildfireStatsRecord] = step;
+    nextWildfireStatsRecord = (nextWildfireStatsRecord + 1) % NUM_WILDFIRE_STATS_RECORDS;
+}
+
+////////////////////////////////////////////////////////////////////
+/// TIMELINE
+////////////////////////////////////////////////////////////////////
+
+// Queue a copy of the current texture as a keyframe of the step about to run, if the timeline
+// wants one. Only one keyframe readback is in flight at a time.
+void beginWildfireKeyframeReadback() {
+    if (wildfireKeyframeFence != nullptr || !wildfireTimeline.isKeyframeDue(wildfireSimulationStep)) {
+        return;
+    }
+
+    if (wildfireKeyframeBuffer == 0) {
+        glGenBuffers(1, &wildfireKeyframeBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireKeyframeBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)wildfireWidth * wildfireHeight * sizeof(WildfireCell), nullptr, GL_STREAM_READ);
+    }
+    else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireKeyframeBuffer);
+    }
+
+    // The compute step wrote the texture through image stores.
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    wildfireKeyframeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    wildfireKeyframeStep = wildfireSimulationStep;
+}
+
+// Compress the keyframe into the timeline once the readback has finished. Returns immediately while the GPU is still copying.
+void finishWildfireKeyframeReadback() {
+    if (wildfireKeyframeFence == nullptr) {
+        return;
+    }
+
+    const GLenum status = glClientWaitSync(wildfireKeyframeFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return;
+    }
+
+    glDeleteSync(wildfireKeyframeFence);
+    wildfireKeyframeFence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireKeyframeBuffer);
+    const WildfireCell* cells = (const WildfireCell*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)wildfireWidth * wildfireHeight * sizeof(WildfireCell), GL_MAP_READ_BIT);
+    if (cells != nullptr) {
+        wildfireTimeline.addKeyframe(wildfireKeyframeStep, cells);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Forget the history, e.g. because the grid was replaced. The steps still in flight are
+// written out first, so none of them lands in the new history.
+void clearWildfireTimeline() {
+    for (int i = 0; i < NUM_WILDFIRE_CHANGE_BUFFERS; i++) {
+        pollWildfireChanges(true);
+    }
+
+    if (wildfireKeyframeFence != nullptr) {
+        glDeleteSync(wildfireKeyframeFence);
+        wildfireKeyframeFence = nullptr;
+    }
+
+    wildfireTimeline.clear();
+}
+
+// Show the step of the timeline in the texture the paused simulation would write next, so the
+// live grid in the current texture is left as it is. Returns false if the step is unreachable.
+bool showWildfireTimelineStep(unsigned int step) {
+    const std::vector<WildfireCell>* cells = wildfireTimeline.seek(step);
+    if (cells == nullptr) {
+        std::cout << "Step " << step << " is not in the timeline" << std::endl;
         return false;
     }
 
-    ////////////////////////////////////////////////////////////////////
-    /// READ FROM LANDSCAPE TEXTURE
-    ////////////////////////////////////////////////////////////////////
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getNextWildfireTexture());
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wildfireWidth, wildfireHeight, GL_RG_INTEGER, GL_UNSIGNED_BYTE, cells->data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    wildfireTimelineScrubStep = step;
+    std::cout << "Timeline step " << step << " of " << wildfireSimulationStep << std::endl;
+    return true;
+}
+
+// Point the terrain back at the live grid. The simulation continues from where it was paused.
+void stopScrubbingWildfireTimeline() {
+    if (!bIsScrubbingWildfireTimeline) {
+        return;
+    }
+
+    bIsScrubbingWildfireTimeline = false;
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
+}
+
+// Apply the scrub keys pressed since the last frame.
+void updateWildfireTimelineScrub() {
+    const int offset = requestedTimelineScrubOffset;
+    requestedTimelineScrubOffset = 0;
 
-    // landscape image
-    int landscape_img_width, landscape_img_height, landscape_channels;
-    unsigned char* landscape_image_data = stbi_load(LANDSCAPE_FILE_NAME, &landscape_img_width, &landscape_img_height, &landscape_channels, STBI_rgb);
+    if (bIsTimelineResumeRequested) {
+        bIsTimelineResumeRequested = false;
+        stopScrubbingWildfireTimeline();
+        return;
+    }
 
-    if (!landscape_image_data) {
-        std::cerr << "Failed to load landscape image: " << LANDSCAPE_FILE_NAME << std::endl;
+    if (offset == 0 || wildfireTimeline.empty()) {
+        return;
+    }
+
+    // Pause at the live step once the changes of every step dispatched so far have arrived.
+    if (!bIsScrubbingWildfireTimeline) {
+        for (int i = 0; i < NUM_WILDFIRE_CHANGE_BUFFERS; i++) {
+            pollWildfireChanges(true);
+        }
+
+        bIsScrubbingWildfireTimeline = true;
+        wildfireTimelineScrubStep = wildfireSimulationStep;
+    }
+
+    const int64_t firstStep = wildfireTimeline.getFirstStep();
+    const int64_t lastStep = std::min<int64_t>(wildfireTimeline.getLastStep(), wildfireSimulationStep);
+    const int64_t step = std::max(firstStep, std::min(lastStep, (int64_t)wildfireTimelineScrubStep + offset));
+
+    showWildfireTimelineStep((unsigned int)step);
+}
+
+////////////////////////////////////////////////////////////////////
+/// SNAPSHOTS
+////////////////////////////////////////////////////////////////////
+
+// The timers follow the cells in the snapshot pixel buffer, at a 4 byte aligned offset.
+GLsizeiptr getWildfireSnapshotTimerOffset() {
+    return ((GLsizeiptr)wildfireWidth * wildfireHeight * sizeof(WildfireCell) + 3) & ~(GLsizeiptr)3;
+}
+
+// Queue a copy of the current texture and the timers into the snapshot pixel buffer. Only one
+// readback is in flight at a time.
+void beginWildfireSnapshotReadback() {
+    if (wildfireSnapshotFence != nullptr) {
+        return;
+    }
+
+    const GLsizeiptr bufferSize = getWildfireSnapshotTimerOffset() + (GLsizeiptr)wildfireWidth * wildfireHeight * sizeof(uint32_t);
+
+    if (wildfireSnapshotBuffer == 0) {
+        glGenBuffers(1, &wildfireSnapshotBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireSnapshotBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+    }
+    else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireSnapshotBuffer);
+    }
+
+    // The compute step wrote the texture through image stores.
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TIMER_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, wildfireTimerTexture);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)getWildfireSnapshotTimerOffset());
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // While scrubbing, the terrain shows the timeline's step rather than the live grid.
+    if (bIsScrubbingWildfireTimeline) {
+        glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+        glBindTexture(GL_TEXTURE_2D, getNextWildfireTexture());
+    }
+
+    wildfireSnapshotFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    wildfireSnapshotStep = wildfireSimulationStep;
+    bWildfireSnapshotHasTimers = !bAreWildfireTimersStale;
+}
+
+// Write the snapshot once the readback has finished. Returns immediately while the GPU is still copying.
+void finishWildfireSnapshotReadback(const WildfireLandscape& landscape) {
+    if (wildfireSnapshotFence == nullptr) {
+        return;
+    }
+
+    const GLenum status = glClientWaitSync(wildfireSnapshotFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return;
+    }
+
+    glDeleteSync(wildfireSnapshotFence);
+    wildfireSnapshotFence = nullptr;
+
+    const GLsizeiptr bufferSize = getWildfireSnapshotTimerOffset() + (GLsizeiptr)wildfireWidth * wildfireHeight * sizeof(uint32_t);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, wildfireSnapshotBuffer);
+    const uint8_t* bytes = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize, GL_MAP_READ_BIT);
+    const WildfireCell* cells = (const WildfireCell*)bytes;
+    const uint32_t* timers = bytes != nullptr && bWildfireSnapshotHasTimers ? (const uint32_t*)(bytes + getWildfireSnapshotTimerOffset()) : nullptr;
+
+    // The planes are encoded straight out of the mapped buffer. The static heights come from the landscape.
+    if (cells != nullptr && saveWildfireSnapshot(WILDFIRE_SNAPSHOT_FILE_NAME, wildfireWidth, wildfireHeight, wildfireSnapshotStep, WILDFIRE_SEED, cells, landscape.heights.data(), timers)) {
+        std::cout << "Saved snapshot at step " << wildfireSnapshotStep << ": " << WILDFIRE_SNAPSHOT_FILE_NAME << std::endl;
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Upload a snapshot into the current texture and resume its step count.
+bool restoreWildfireSnapshot(const char* path) {
+    WildfireSnapshot snapshot;
+    if (!loadWildfireSnapshot(path, snapshot)) {
         return false;
     }
 
-    ////////////////////////////////////////////////////////////////////
-    /// CREATE TEXTURE DATA FROM LANDSCAPE AND HEIGHTMAP IMAGES
-    ////////////////////////////////////////////////////////////////////
+    if (snapshot.width != wildfireWidth || snapshot.height != wildfireHeight) {
+        std::cerr << "Snapshot is " << snapshot.width << "x" << snapshot.height << ", the grid is " << wildfireWidth << "x" << wildfireHeight << std::endl;
+        return false;
+    }
 
-    for (int pixel_y = 0; pixel_y < height; pixel_y++) {
-        for (int pixel_x = 0; pixel_x < width; pixel_x++) {
-            int pixel_index = pixel_y * width + pixel_x;
+    if (snapshot.seed != WILDFIRE_SEED) {
+        std::cout << "Snapshot was taken with seed " << snapshot.seed << ", continuing with seed " << WILDFIRE_SEED << std::endl;
+    }
 
-            // Determine what the current pixel's data index is in the array.
-            int pixel_data_index = pixel_index * 4;
+    // The history led up to the grid being replaced, so it starts over from the snapshot.
+    if (RECORD_WILDFIRE_TIMELINE) {
+        stopScrubbingWildfireTimeline();
+        clearWildfireTimeline();
+    }
 
-            // Determine the color value of the corresponding landscape image pixel.
-            int landscape_image_index = pixel_index * landscape_channels;
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
 
-            int r = (int)landscape_image_data[landscape_image_index];     // Red channel
-            int g = (int)landscape_image_data[landscape_image_index + 1]; // Green channel
-            int b = (int)landscape_image_data[landscape_image_index + 2]; // Blue channel
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wildfireWidth, wildfireHeight, GL_RG_INTEGER, GL_UNSIGNED_BYTE, snapshot.cells.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-            // Based off the pixel color, 
-            if (r == 181 && g == 219 && b == 235) {
-                texture_data[pixel_data_index + 0] = MATERIAL_WATER;
-            }
-            else if (r == 207 && g == 198 && b == 180) {
-                texture_data[pixel_data_index + 0] = MATERIAL_BEDROCK;
-            }
-            else if (r == 121 && g == 150 && b == 114) {
-                texture_data[pixel_data_index + 0] = MATERIAL_GRASS;
-            }
-            else if (r == 32 && g == 99 && b == 84) {
-                texture_data[pixel_data_index + 0] = MATERIAL_TREE_1;
-            }
-            else if (r == 66 && g == 143 && b == 30) {
-                texture_data[pixel_data_index + 0] = MATERIAL_TREE_2;
-            }
-            else if (r == 185 && g == 209 && b == 50) {
-                texture_data[pixel_data_index + 0] = MATERIAL_TREE_3;
-            }
+    // The timers are taken as drawn with the current parameters. Without them the next step redraws them.
+    if (!snapshot.timers.empty()) {
+        glActiveTexture(GL_TEXTURE0 + WILDFIRE_TIMER_TEXTURE_INDEX);
+        glBindTexture(GL_TEXTURE_2D, wildfireTimerTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wildfireWidth, wildfireHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, snapshot.timers.data());
 
-            // Write the current state value.
-            texture_data[pixel_data_index + 1] = STATE_NOT_ON_FIRE;
+        wildfireTimerGrassRegrowProbability = wildfireParameters.grassRegrowProbability;
+        wildfireTimerTreeRegrowProbability = wildfireParameters.treeRegrowProbability;
+        bAreWildfireTimersStale = false;
+    }
+    else {
+        bAreWildfireTimersStale = true;
+    }
+
+    wildfireSimulationStep = snapshot.stepCount;
+    bIsWildfireGridReplaced = true;
 
-            // Write the heightmap value.
-            texture_data[pixel_data_index + 2] = heightmap_image_data[pixel_index] / 255.0f;
+    // The ignitions of the steps still in flight belong to the old grid.
+    if (COLLECT_WILDFIRE_STATS) {
+        for (int i = 0; i < NUM_WILDFIRE_STATS_RECORDS; i++) {
+            pollWildfireStats(true);
         }
+        wildfireBurnedArea.reset(snapshot.cells.data(), snapshot.cells.size());
+    }
+
+    // The log replays from the initial landscape, so it cannot describe a jump to another state.
+    if (wildfireEventRecorder.isOpen()) {
+        wildfireEventRecorder.close(wildfireSimulationStep, (float)glfwGetTime());
+        std::cout << "Stopped recording events, a restored snapshot cannot be replayed" << std::endl;
+    }
+
+    std::cout << "Restored snapshot at step " << wildfireSimulationStep << ": " << path << std::endl;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+/// GENERATE WILDFIRE TEXTURE
+////////////////////////////////////////////////////////////////////
+
+GLboolean generateWildfireTexture(GLsizei offset, GLuint* textures, GLuint heightTexture, GLuint slopeTexture, const WildfireLandscape& landscape) {
+    WILDFIRE_TRACE_ZONE("generateWildfireTexture");
+
+    const GLsizei width = landscape.width;
+    const GLsizei height = landscape.height;
+
+    ////////////////////////////////////////////////////////////////////
+    /// CREATE TEXTURE DATA FROM LANDSCAPE AND HEIGHTMAP IMAGES
+    ////////////////////////////////////////////////////////////////////
+
+    // Each cell is a GL_RG8UI texel (2 bytes instead of a 16 byte RGBA32F texel).
+    // data.r - Material Type
+    // data.g - Current State (Not On Fire to Start With)
+    std::vector<WildfireCell> texture_data(landscape.materials.size());
+
+    for (size_t pixel_index = 0; pixel_index < texture_data.size(); pixel_index++) {
+        texture_data[pixel_index].material = landscape.materials[pixel_index];
+        texture_data[pixel_index].state = STATE_NOT_ON_FIRE;
     }
-    
-    stbi_image_free(heightmap_image_data);
-    stbi_image_free(landscape_image_data);
 
     // Actually bind the OpenGL texture and set up relevant parameters.
     for (GLsizei i = 0; i < 2; i++) {
@@ -226,27 +897,81 @@ GLboolean generateWildfireTexture(GLsizei offset, GLuint* textures, GLsizei widt
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
         // Set border to nonsense values
-        float borderColor[] = { -1.0f, -1.0f, 0.0f, 1.0f }; // RGBA values
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        GLuint borderColor[] = { 255, 255, 0, 0 }; // RGBA values
+        glTexParameterIuiv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, texture_data);
+        // Rows of 2 byte texels are not necessarily 4 byte aligned.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, texture_data.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
         // Alternate between reading and writing.
         if (i == 0) {
-            glBindImageTexture(finalOffset, textures[i], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+            glBindImageTexture(finalOffset, textures[i], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG8UI);
         }
         else {
-            glBindImageTexture(finalOffset, textures[i], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+            glBindImageTexture(finalOffset, textures[i], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG8UI);
         }
     }
 
+    ////////////////////////////////////////////////////////////////////
+    /// UPLOAD THE STATIC HEIGHT PLANE ONCE
+    ////////////////////////////////////////////////////////////////////
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_HEIGHT_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, width, height, 0, GL_RED, GL_UNSIGNED_SHORT, landscape.heights.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindImageTexture(WILDFIRE_HEIGHT_TEXTURE_INDEX, heightTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R16);
+
+    ////////////////////////////////////////////////////////////////////
+    /// UPLOAD THE STATIC SLOPE FACTOR PLANE ONCE
+    ////////////////////////////////////////////////////////////////////
+
+    const std::vector<uint32_t> slopeFactors = computeWildfireSlopeFactors(landscape);
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_SLOPE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, slopeTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, slopeFactors.data());
+
+    glBindImageTexture(WILDFIRE_SLOPE_TEXTURE_INDEX, slopeTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+
+    ////////////////////////////////////////////////////////////////////
+    /// CREATE THE TIMER PLANE
+    ////////////////////////////////////////////////////////////////////
+
+    // The first step draws every timer (see bAreWildfireTimersStale).
+    const std::vector<uint32_t> timers(landscape.materials.size(), WILDFIRE_TIMER_NEVER);
+
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TIMER_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, wildfireTimerTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, timers.data());
+
+    glBindImageTexture(WILDFIRE_TIMER_TEXTURE_INDEX, wildfireTimerTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
     // Check for any errors during the process
     GLenum err = glGetError();
     return (err == GL_NO_ERROR);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Run the simulation on the CPU without creating a window or an OpenGL context.
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        return runWildfireHeadless(argc - 2, argv + 2, LANDSCAPE_FILE_NAME, HEIGHTMAP_FILE_NAME);
+    }
+
+    setWildfireTraceThreadName("Main thread");
+    WildfireTraceZone startupZone("Startup");
 
 #pragma region Initialize
 
@@ -308,16 +1033,47 @@ int main()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    ////////////////////////////////////////////////////////////////////
+    /// INITIALIZE IMGUI AND THE FRAME PROFILER
+    ////////////////////////////////////////////////////////////////////
+
+    if (PROFILE_FRAME_PASSES) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+
+        // The mouse steers the camera, so the overlay is display only.
+        ImGuiIO& io = ImGui::GetIO();
+        io.ConfigFlags |= ImGuiConfigFlags_NoMouse;
+        io.IniFilename = nullptr;
+
+        ImGui::StyleColorsDark();
+
+        // Chains to the callbacks installed above.
+        ImGui_ImplGlfw_InitForOpenGL(mainWindow, true);
+        ImGui_ImplOpenGL3_Init(IMGUI_GLSL_VERSION);
+
+        computeStepPass = frameProfiler.addPass("Compute step");
+        stateReadbackPass = frameProfiler.addPass("State readback");
+        terrainPass = frameProfiler.addPass("Terrain tessellation");
+        treePass = frameProfiler.addPass("Tree instances");
+        frameProfiler.create();
+    }
+
     ////////////////////////////////////////////////////////////////////
     /// BUILD AND COMPILE ALL SHADERS
     ////////////////////////////////////////////////////////////////////
 
-    Shader terrainMeshShader(TERRAIN_MESH_VERTEX_SHADER, TERRAIN_MESH_FRAGMENT_SHADER, nullptr, TERRAIN_MESH_TESSELLATION_CONTROL_SHADER, TERRAIN_MESH_TESSELLATION_EVALUATION_SHADER);
+    WildfireTraceZone shaderZone("Compile shaders and load the tree model");
+
+    Shader terrainMeshShader(TERRAIN_MESH_VERTEX_SHADER, TERRAIN_MESH_FRAGMENT_SHADER, nullptr, TERRAIN_MESH_TESSELLATION_CONTROL_SHADER, TERRAIN_MESH_TESSELLATION_EVALUATION_SHADER, getWildfireShaderDefinitions());
     
     Model treeModel("Meshes/tree.obj");
     Shader treeModelShader(TREE_FOLIAGE_VERTEX_SHADER, TREE_FOLIAGE_FRAGMENT_SHADER);
 
-    ComputeShader wildfireCompute(WILDFIRE_COMPUTE_SHADER);
+    // Compile the permutation of the default rules up front; others are compiled when first needed.
+    getWildfireComputeVariant(getWildfireShaderRules(wildfireParameters, false));
+
+    shaderZone.end();
 
 #pragma region LoadingHeightMapTexture
 
@@ -325,6 +1081,8 @@ int main()
     /// LOAD HEIGHTMAP TEXTURE FOR TERRAIN SHADER
     ////////////////////////////////////////////////////////////////////
 
+    WildfireTraceZone heightMapZone("Load heightmap texture");
+
     GLuint heightMapTexture;
     glGenTextures(1, &heightMapTexture);
 
@@ -360,10 +1118,14 @@ int main()
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, heightmapImageWidth, heightmapImageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, heightMapData);
     glGenerateMipmap(GL_TEXTURE_2D);
 
+    terrainWorldSize = glm::vec2(heightmapImageWidth, heightmapImageHeight);
+
     terrainMeshShader.setInt("heightMap", HEIGHTMAP_TEXTURE_INDEX);
 
     stbi_image_free(heightMapData);
 
+    heightMapZone.end();
+
 #pragma endregion
 
 #pragma region LoadingComputeShader
@@ -372,11 +1134,57 @@ int main()
     /// INITIALIZE COMPUTE SHADER
     ////////////////////////////////////////////////////////////////////
 
-    const GLsizei numWildfireTextures = 2;
-    GLuint wildfireTextures[numWildfireTextures];
-    glGenTextures(numWildfireTextures, wildfireTextures);
+    // The grid size comes from the landscape image. The heightmap is resampled to it if needed.
+    WildfireLandscape landscape;
+    if (!loadWildfireLandscape(LANDSCAPE_FILE_NAME, HEIGHTMAP_FILE_NAME, 0, 0, landscape)) {
+        return -1;
+    }
+
+    wildfireWidth = landscape.width;
+    wildfireHeight = landscape.height;
+
+    wildfireParameters.seed = WILDFIRE_SEED;
+    if (RECORD_WILDFIRE_EVENTS) {
+        wildfireEventRecorder.open(WILDFIRE_EVENT_LOG_FILE_NAME, wildfireWidth, wildfireHeight, wildfireParameters);
+    }
+
+    createWildfireRuleTableBuffer();
+
+    if (WILDFIRE_WIND_FIELD_FILE_NAME != nullptr && wildfireWindField.open(WILDFIRE_WIND_FIELD_FILE_NAME)) {
+        createWildfireWindFieldTexture();
+    }
+
+    if (STREAM_WILDFIRE_CHANGES) {
+        createWildfireChangeBuffers();
+        wildfireDeltaStream.open(WILDFIRE_DELTA_STREAM_FILE_NAME, wildfireWidth, wildfireHeight);
+    }
 
-    generateWildfireTexture(2, wildfireTextures, WILDFIRE_WIDTH, WILDFIRE_HEIGHT);
+    if (RECORD_WILDFIRE_TIMELINE) {
+        wildfireTimeline.reset(wildfireWidth, wildfireHeight, WILDFIRE_TIMELINE_KEYFRAME_INTERVAL, WILDFIRE_TIMELINE_MEMORY_BUDGET);
+    }
+
+    if (COLLECT_WILDFIRE_STATS) {
+        createWildfireStatsBuffer();
+        if (WILDFIRE_STATS_CSV_FILE_NAME != nullptr) {
+            wildfireStatsCsv.open(WILDFIRE_STATS_CSV_FILE_NAME);
+        }
+    }
+
+    glGenTextures(NUM_WILDFIRE_TEXTURES, wildfireTextures);
+
+    GLuint wildfireHeightTexture;
+    glGenTextures(1, &wildfireHeightTexture);
+
+    GLuint wildfireSlopeTexture;
+    glGenTextures(1, &wildfireSlopeTexture);
+
+    glGenTextures(1, &wildfireTimerTexture);
+
+    generateWildfireTexture(WILDFIRE_TEXTURE_INDEX, wildfireTextures, wildfireHeightTexture, wildfireSlopeTexture, landscape);
+
+    // The terrain samples the current texture on the wildfire texture unit.
+    glActiveTexture(GL_TEXTURE0 + WILDFIRE_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_2D, getCurrentWildfireTexture());
 
 #pragma endregion
 
@@ -456,64 +1264,35 @@ int main()
     /// INITIALIZE TREE FOLIAGE INSTANCE RENDERING
     ////////////////////////////////////////////////////////////////////
 
-    const size_t pixelCount = WILDFIRE_WIDTH * WILDFIRE_HEIGHT;
-
-    ////////////////////////////////////////////////////////////////////
-    /// LOAD LANDSCAPE IMAGE FROM DIRECTORY
-    ////////////////////////////////////////////////////////////////////
-
-    int landscape_img_width, landscape_img_height, landscape_channels;
-    unsigned char* landscape_image_data = stbi_load(LANDSCAPE_FILE_NAME, &landscape_img_width, &landscape_img_height, &landscape_channels, STBI_rgb);
-
-    if (!landscape_image_data) {
-        std::cerr << "Failed to load landscape image: " << LANDSCAPE_FILE_NAME << std::endl;
-        return false;
-    }
-
-    ////////////////////////////////////////////////////////////////////
-    /// LOAD HEIGHTMAP IMAGE FROM DIRECTORY
-    ////////////////////////////////////////////////////////////////////
-
-    int heightmap_img_width, heightmap_img_height, heightmap_channels;
-    unsigned char* heightmap_image_data = stbi_load(HEIGHTMAP_FILE_NAME, &heightmap_img_width, &heightmap_img_height, &heightmap_channels, STBI_grey);
-
-    if (!heightmap_image_data) {
-        std::cerr << "Failed to load heightmap image: " << HEIGHTMAP_FILE_NAME << std::endl;
-        return false;
-    }
-
     ////////////////////////////////////////////////////////////////////
     /// COUNT NUMBER OF TREE PIXELS IN IMAGE
     ////////////////////////////////////////////////////////////////////
 
-    int totalNumberOfTrees = 0;
-
-    for (int y = 0; y < WILDFIRE_HEIGHT; y++) {
-        for (int x = 0; x < WILDFIRE_HEIGHT; x++) {
-            int index = (y * WILDFIRE_WIDTH + x) * landscape_channels;
+    WildfireTraceZone treeCountZone("Count tree pixels");
 
-            int r = (int)landscape_image_data[index];
-            int g = (int)landscape_image_data[index + 1];
-            int b = (int)landscape_image_data[index + 2];
-
-            const bool bIsTree1 = r == 32 && g == 99 && b == 84;
-            const bool bIsTree2 = r == 66 && g == 143 && b == 30;
-            const bool bIsTree3 = r == 185 && g == 209 && b == 50;
+    // The landscape was already classified (and resampled to the grid) for the simulation.
+    int totalNumberOfTrees = 0;
 
-            if (bIsTree1 || bIsTree2 || bIsTree3) {
-                ++totalNumberOfTrees;
-            }
+    for (unsigned char material : landscape.materials) {
+        if (isTreeMaterial(material)) {
+            ++totalNumberOfTrees;
         }
     }
 
+    treeCountZone.end();
+
     ////////////////////////////////////////////////////////////////////
     /// SET UP TREE MODEL TRANSFORM MATRICES
     ////////////////////////////////////////////////////////////////////
 
+    WildfireTraceZone treePlacementZone("Place tree instances");
+
     int current_tree_instance_index = 0;
 
     // Determine the maximum number of trees possible based from the maximum number of grids in each direction.
-    TreeModelInstanceCount = NUMBER_OF_TREE_GRIDS_X * NUMBER_OF_TREE_GRIDS_Y;
+    const int numberOfTreeGridsX = wildfireWidth / NUMBER_OF_PIXELS_IN_TREE_GRID;
+    const int numberOfTreeGridsY = wildfireHeight / NUMBER_OF_PIXELS_IN_TREE_GRID;
+    TreeModelInstanceCount = numberOfTreeGridsX * numberOfTreeGridsY;
 
     glm::mat4* treeModelMatrices = new glm::mat4[TreeModelInstanceCount];
 
@@ -526,8 +1305,8 @@ int main()
 
     int totalTreeMeshCount = 0;
 
-    for (int y = 0; y < NUMBER_OF_TREE_GRIDS_Y; y++) {
-        for (int x = 0; x < NUMBER_OF_TREE_GRIDS_X; x++) {
+    for (int y = 0; y < numberOfTreeGridsY; y++) {
+        for (int x = 0; x < numberOfTreeGridsX; x++) {
 
             int numberOfTreesInGrid = 0;
             const int PIXEL_X = x * NUMBER_OF_PIXELS_IN_TREE_GRID;
@@ -538,17 +1317,7 @@ int main()
                 int dx = PIXEL_X + TREE_GRID_PIXEL_OFFSETS[index_pixel_grid][0];
                 int dy = PIXEL_Y + TREE_GRID_PIXEL_OFFSETS[index_pixel_grid][1];
 
-                int index = (dy * WILDFIRE_WIDTH + dx) * landscape_channels;
-
-                int r = (int)landscape_image_data[index];
-                int g = (int)landscape_image_data[index + 1];
-                int b = (int)landscape_image_data[index + 2];
-
-                const bool bIsTree1 = r == 32 && g == 99 && b == 84;
-                const bool bIsTree2 = r == 66 && g == 143 && b == 30;
-                const bool bIsTree3 = r == 185 && g == 209 && b == 50;
-
-                if (bIsTree1 || bIsTree2 || bIsTree3) {
+                if (isTreeMaterial(landscape.materials[(size_t)dy * wildfireWidth + dx])) {
                     ++numberOfTreesInGrid;
                 }
             }
@@ -560,7 +1329,7 @@ int main()
                 constexpr float HEIGHT_SCALE = 768.f;
                 constexpr float HEIGHT_DISPLACEMENT = 0.f;
 
-                float heightValue = (heightmap_image_data[PIXEL_Y * heightmap_img_width + PIXEL_X] / 255.0f) * HEIGHT_SCALE;
+                float heightValue = (landscape.heights[(size_t)PIXEL_Y * wildfireWidth + PIXEL_X] / 65535.0f) * HEIGHT_SCALE;
                 heightValue += HEIGHT_DISPLACEMENT;
 
                 // Set the location.
@@ -568,7 +1337,10 @@ int main()
                 std::mt19937 gen(rd());                          // Mersenne Twister RNG
                 std::uniform_real_distribution<float> dist(-5.0f, 5.0f);  // Range [0.0, 1.0)
 
-                glm::vec3 newLocation = glm::vec3(PIXEL_X - (WILDFIRE_WIDTH / 2.f) + dist(gen), heightValue, PIXEL_Y - (WILDFIRE_WIDTH / 2.f) + dist(gen));
+                // Map the grid cell onto the terrain, which need not have one world unit per cell.
+                const glm::vec2 cellWorldPos = (glm::vec2(PIXEL_X, PIXEL_Y) / glm::vec2(wildfireWidth, wildfireHeight) - 0.5f) * terrainWorldSize;
+
+                glm::vec3 newLocation = glm::vec3(cellWorldPos.x + dist(gen), heightValue, cellWorldPos.y + dist(gen));
 
                 treeModelMatrices[current_tree_instance_index] = glm::translate(treeModelMatrices[current_tree_instance_index], newLocation);
 
@@ -582,8 +1354,7 @@ int main()
         }
     }
 
-    stbi_image_free(landscape_image_data);
-    stbi_image_free(heightmap_image_data);
+    treePlacementZone.end();
 
     unsigned int TREE_VBO;
     glGenBuffers(1, &TREE_VBO);
@@ -615,6 +1386,11 @@ int main()
 
 #pragma endregion FoliageSetUp
 
+    startupZone.end();
+    if (WILDFIRE_STARTUP_TRACE_FILE_NAME != nullptr) {
+        writeWildfireTrace(WILDFIRE_STARTUP_TRACE_FILE_NAME);
+    }
+
 #pragma region RenderingLoop
 
     // Number of seconds since the last frame
@@ -633,9 +1409,16 @@ int main()
 
         //if (deltaTime >= fpsLimit) {
         {
+            WILDFIRE_TRACE_ZONE("Frame");
+
             // Output the current frame rate.
             if (frameCounter >= (1.0 / MIN_FRAME_TIME_LIMIT)) {
-                std::cout << "FPS: " << frameCounter / (currentTime - lastFPSCheckTime) << std::endl;
+                std::cout << "FPS: " << frameCounter / (currentTime - lastFPSCheckTime);
+                if (!wildfireStatsHistory.empty()) {
+                    const WildfireStats& stats = wildfireStatsHistory.getLatest();
+                    std::cout << "  Step: " << stats.stepCount << "  Burning: " << stats.burningCellCount << "  Perimeter: " << stats.perimeterEdgeCount;
+                }
+                std::cout << std::endl;
                 frameCounter = 0;
                 lastFPSCheckTime = currentTime;
             }
@@ -647,32 +1430,122 @@ int main()
             /// PROCESS INPUT
             ////////////////////////////////////////////////////////////////////
             
+            WildfireTraceZone inputZone("Process input");
+
             processInput(mainWindow);
 
+            if (PROFILE_FRAME_PASSES) {
+                frameProfiler.beginFrame();
+            }
+
+            if (bIsSnapshotLoadRequested) {
+                bIsSnapshotLoadRequested = false;
+                restoreWildfireSnapshot(WILDFIRE_SNAPSHOT_FILE_NAME);
+            }
+
+            inputZone.end();
+
             ////////////////////////////////////////////////////////////////////
-            /// RUN COMPUTE SHADER
+            /// READ BACK AND UPLOAD STATE
             ////////////////////////////////////////////////////////////////////
 
-            wildfireCompute.use();
-            wildfireCompute.setInt("frameCounter", frameCounter);
-            wildfireCompute.setFloat("iTime", currentTime);
-            wildfireCompute.setBool("mouseDown", bIsMouseDown);
-            wildfireCompute.setVec2("mousePos", mousePos);
+            WildfireTraceZone readbackZone("State readback");
+            frameProfiler.beginPass(stateReadbackPass);
+
+            if (RECORD_WILDFIRE_TIMELINE) {
+                updateWildfireTimelineScrub();
+            }
+
+            // Record the grid the next step starts from, if a keyframe is due.
+            if (RECORD_WILDFIRE_TIMELINE && !bIsScrubbingWildfireTimeline) {
+                beginWildfireKeyframeReadback();
+            }
+
+            if (bIsSnapshotSaveRequested) {
+                bIsSnapshotSaveRequested = false;
+                beginWildfireSnapshotReadback();
+            }
+
+            finishWildfireSnapshotReadback(landscape);
+            if (RECORD_WILDFIRE_TIMELINE) {
+                finishWildfireKeyframeReadback();
+            }
+
+            frameProfiler.endPass(stateReadbackPass);
+            readbackZone.end();
 
-            wildfireCompute.setBool("mouseDown", bIsMouseDown);
+            ////////////////////////////////////////////////////////////////////
+            /// RUN COMPUTE SHADER
+            ////////////////////////////////////////////////////////////////////
 
-            if (bIsMouseDown == true) {
+            // The simulation is paused while scrubbing through the timeline. Clicks do not ignite.
+            if (bIsScrubbingWildfireTimeline) {
                 bIsMouseDown = false;
-                std::cout << mousePos.x << " " << mousePos.y << std::endl;
-                wildfireCompute.setVec2("mousePos", mousePos);
             }
+            else {
+                WILDFIRE_TRACE_ZONE("Compute step");
+
+                const bool bUseWindField = advanceWildfireWindField(wildfireSimulationStep);
+                ComputeShader& wildfireCompute = getWildfireComputeVariant(getWildfireShaderRules(wildfireParameters, bUseWindField));
+
+                wildfireCompute.use();
+                wildfireCompute.setUVec2("seed", (unsigned int)WILDFIRE_SEED, (unsigned int)(WILDFIRE_SEED >> 32));
+                wildfireCompute.setUInt("simulationStep", wildfireSimulationStep);
+                setWildfireParameterUniforms(wildfireCompute, wildfireParameters);
+                updateWildfireRuleTable(wildfireParameters);
+                if (bUseWindField) {
+                    updateWildfireWindField(wildfireCompute);
+                }
+                wildfireCompute.setBool("mouseDown", bIsMouseDown);
+                wildfireCompute.setVec2("mousePos", mousePos);
+
+                // The waiting times are memoryless, so timers drawn with other probabilities are simply redrawn.
+                const bool bResampleTimers = bAreWildfireTimersStale
+                    || wildfireParameters.grassRegrowProbability != wildfireTimerGrassRegrowProbability
+                    || wildfireParameters.treeRegrowProbability != wildfireTimerTreeRegrowProbability;
+                wildfireCompute.setBool("resampleTimers", bResampleTimers);
+                if (bResampleTimers) {
+                    wildfireTimerGrassRegrowProbability = wildfireParameters.grassRegrowProbability;
+                    wildfireTimerTreeRegrowProbability = wildfireParameters.treeRegrowProbability;
+                    bAreWildfireTimersStale = false;
+                }
+
+                // Log what this step sees before it is dispatched.
+                wildfireEventRecorder.recordParameters(wildfireSimulationStep, wildfireParameters);
 
-            glDispatchCompute(WILDFIRE_WIDTH, WILDFIRE_HEIGHT, 1);
-            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+                if (bIsMouseDown == true) {
+                    bIsMouseDown = false;
+                    std::cout << mousePos.x << " " << mousePos.y << std::endl;
+                    wildfireEventRecorder.recordIgnition(wildfireSimulationStep, mousePos);
+                }
+
+                bindWildfireImagesForStep();
+                if (STREAM_WILDFIRE_CHANGES) {
+                    bindWildfireChangeBufferForStep();
+                }
+                if (COLLECT_WILDFIRE_STATS) {
+                    bindWildfireStatsRecordForStep(wildfireCompute);
+                }
+
+                frameProfiler.beginPass(computeStepPass);
+                glDispatchCompute(getWildfireDispatchSize(wildfireWidth), getWildfireDispatchSize(wildfireHeight), 1);
 
-            glCopyImageSubData(wildfireTextures[1], GL_TEXTURE_2D, 0, 0, 0, 0,
-                wildfireTextures[0], GL_TEXTURE_2D, 0, 0, 0, 0,
-                WILDFIRE_WIDTH, WILDFIRE_HEIGHT, 1);
+                // The next step reads the result as an image, and the terrain samples it as a texture.
+                glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+                frameProfiler.endPass(computeStepPass);
+
+                if (STREAM_WILDFIRE_CHANGES) {
+                    endWildfireChangeStep(wildfireSimulationStep);
+                    pollWildfireChanges(false);
+                }
+                if (COLLECT_WILDFIRE_STATS) {
+                    endWildfireStatsStep(wildfireSimulationStep);
+                    pollWildfireStats(false);
+                }
+
+                swapWildfireTextures();
+                ++wildfireSimulationStep;
+            }
 
             ////////////////////////////////////////////////////////////////////
             /// RENDER TERRAIN
@@ -685,6 +1558,9 @@ int main()
             glm::mat4 cameraProjection = glm::perspective(glm::radians(camera.Zoom), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100000.0f);
             glm::mat4 cameraViewMatrix = camera.GetViewMatrix();
 
+            WildfireTraceZone terrainZone("Render terrain");
+            frameProfiler.beginPass(terrainPass);
+
             // be sure to activate shader when setting uniforms/drawing objects
             terrainMeshShader.use();
             
@@ -695,6 +1571,7 @@ int main()
             terrainMeshShader.setMat4("view", cameraViewMatrix);
             terrainMeshShader.setInt("landscapeTexture", LANDSCAPE_TEXTURE_INDEX);
             terrainMeshShader.setInt("wildfireTexture", WILDFIRE_TEXTURE_INDEX);
+            terrainMeshShader.setInt("wildfireHeightTexture", WILDFIRE_HEIGHT_TEXTURE_INDEX);
             terrainMeshShader.setInt("heightMap", HEIGHTMAP_TEXTURE_INDEX);
 
             glBindVertexArray(terrainVAO);
@@ -702,10 +1579,16 @@ int main()
             glDrawArrays(GL_PATCHES, 0, NUM_PATCH_PTS * resolutionFactor * resolutionFactor); // Count depends on your patch size
             glBindVertexArray(0);
 
+            frameProfiler.endPass(terrainPass);
+            terrainZone.end();
+
             ////////////////////////////////////////////////////////////////////
             /// RENDER TREES
             ////////////////////////////////////////////////////////////////////
 
+            WildfireTraceZone treeZone("Render trees");
+            frameProfiler.beginPass(treePass);
+
             treeModelShader.use();
             treeModelShader.setMat4("projection", cameraProjection);
             treeModelShader.setMat4("view", cameraViewMatrix);
@@ -717,12 +1600,38 @@ int main()
                 glDrawElementsInstanced(GL_TRIANGLES, treeModel.meshes[Index_TreeMesh].indices.size(), GL_UNSIGNED_INT, 0, TreeModelInstanceCount);
             }
 
+            frameProfiler.endPass(treePass);
+            treeZone.end();
+
+            ////////////////////////////////////////////////////////////////////
+            /// RENDER PROFILER OVERLAY
+            ////////////////////////////////////////////////////////////////////
+
+            if (PROFILE_FRAME_PASSES) {
+                WILDFIRE_TRACE_ZONE("Render profiler overlay");
+
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+
+                if (bIsProfilerOverlayVisible) {
+                    frameProfiler.drawOverlay();
+                }
+
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+                frameProfiler.endFrame();
+            }
+
             ////////////////////////////////////////////////////////////////////
             /// SWAP GLFW BUFFERS AND CHECK POLL EVENTS
             ////////////////////////////////////////////////////////////////////
 
+            WildfireTraceZone swapZone("Swap buffers and poll events");
             glfwSwapBuffers(mainWindow);
             glfwPollEvents();
+            swapZone.end();
 
             lastFrameTime = currentTime;
         }
@@ -730,6 +1639,34 @@ int main()
 
 #pragma endregion RenderingLoop
 
+    wildfireEventRecorder.close(wildfireSimulationStep, (float)glfwGetTime());
+
+    // Write out the steps still in flight.
+    if (STREAM_WILDFIRE_CHANGES) {
+        for (int i = 0; i < NUM_WILDFIRE_CHANGE_BUFFERS; i++) {
+            pollWildfireChanges(true);
+        }
+        wildfireDeltaStream.close();
+    }
+
+    if (COLLECT_WILDFIRE_STATS) {
+        for (int i = 0; i < NUM_WILDFIRE_STATS_RECORDS; i++) {
+            pollWildfireStats(true);
+        }
+        wildfireStatsCsv.close();
+    }
+
+    if (WILDFIRE_FRAME_TRACE_FILE_NAME != nullptr) {
+        writeWildfireTrace(WILDFIRE_FRAME_TRACE_FILE_NAME);
+    }
+
+    if (PROFILE_FRAME_PASSES) {
+        frameProfiler.destroy();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
+
     ////////////////////////////////////////////////////////////////////
     /// TERMINATE GLFW
     ////////////////////////////////////////////////////////////////////
@@ -765,6 +1702,24 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 // ---------------------------------------------------------------------------------------------
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int modifiers)
 {
+    // Scrub through the timeline, repeating while the key is held.
+    if (action == GLFW_PRESS || action == GLFW_REPEAT)
+    {
+        switch (key)
+        {
+        case GLFW_KEY_LEFT:
+        case GLFW_KEY_RIGHT:
+            requestedTimelineScrubOffset += key == GLFW_KEY_LEFT ? -1 : 1;
+            break;
+        case GLFW_KEY_PAGE_UP:
+        case GLFW_KEY_PAGE_DOWN:
+            requestedTimelineScrubOffset += (key == GLFW_KEY_PAGE_UP ? -1 : 1) * (int)WILDFIRE_TIMELINE_KEYFRAME_INTERVAL;
+            break;
+        default:
+            break;
+        }
+    }
+
     // Used to close the window if the user presses ESC.
     if (action == GLFW_PRESS)
     {
@@ -773,6 +1728,35 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         case GLFW_KEY_ESCAPE:
             glfwSetWindowShouldClose(window, true);
             break;
+        case GLFW_KEY_F1:
+            bIsProfilerOverlayVisible = !bIsProfilerOverlayVisible;
+            break;
+        case GLFW_KEY_F5:
+            bIsSnapshotSaveRequested = true;
+            break;
+        case GLFW_KEY_F9:
+            bIsSnapshotLoadRequested = true;
+            break;
+        case GLFW_KEY_HOME:
+            requestedTimelineScrubOffset = INT_MIN / 2;
+            break;
+        case GLFW_KEY_END:
+            bIsTimelineResumeRequested = true;
+            break;
+        case GLFW_KEY_Q:
+            // Cycle through no wind (0), the 8 directions of GetWindDirection and the continuous angle.
+            wildfireParameters.windDirectionIndex = (wildfireParameters.windDirectionIndex + NUM_WIND_DIRECTIONS - 1) % NUM_WIND_DIRECTIONS;
+            break;
+        case GLFW_KEY_E:
+            wildfireParameters.windDirectionIndex = (wildfireParameters.windDirectionIndex + 1) % NUM_WIND_DIRECTIONS;
+            break;
+        case GLFW_KEY_Z:
+        case GLFW_KEY_C:
+            // Turn the wind counter-clockwise (Z) or clockwise (C) by any angle.
+            wildfireParameters.windDirectionIndex = WIND_DIRECTION_ANGLE;
+            wildfireParameters.windAngleDegrees = std::fmod(wildfireParameters.windAngleDegrees + (key == GLFW_KEY_Z ? WIND_ANGLE_STEP_DEGREES : 360.0f - WIND_ANGLE_STEP_DEGREES), 360.0f);
+            std::cout << "Wind angle: " << wildfireParameters.windAngleDegrees << std::endl;
+            break;
         default:
             break;
         }
@@ -827,8 +1811,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 // Normalize coordinates based on terrain dimensions
                 // Assuming terrain spans from -heightmapImageWidth/2 to +heightmapImageWidth/2
                 // and from -heightmapImageHeight/2 to +heightmapImageHeight/2
-                mousePos.x = (intersectionPoint.x + WILDFIRE_WIDTH / 2.0f) / WILDFIRE_WIDTH;
-                mousePos.y = (intersectionPoint.z + WILDFIRE_HEIGHT / 2.0f) / WILDFIRE_HEIGHT;
+                mousePos.x = (intersectionPoint.x + terrainWorldSize.x / 2.0f) / terrainWorldSize.x;
+                mousePos.y = (intersectionPoint.z + terrainWorldSize.y / 2.0f) / terrainWorldSize.y;
 
                 // Clamp to [0, 1] range
                 mousePos.x = glm::clamp(mousePos.x, 0.0f, 1.0f);